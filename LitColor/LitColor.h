@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -90,10 +92,10 @@ private:
 
 	void generateIntFromFloat()
 	{
-		_redI = static_cast<int>(_redF * 255.0f);
-		_greenI = static_cast<int>(_greenF * 255.0f);
-		_blueI = static_cast<int>(_blueF * 255.0f);
-		_alphaI = static_cast<int>(_alphaF * 255.0f);
+		_redI = FloatToChannel(_redF);
+		_greenI = FloatToChannel(_greenF);
+		_blueI = FloatToChannel(_blueF);
+		_alphaI = FloatToChannel(_alphaF);
 	}
 
 	void generateRgbaFromInt()
@@ -224,9 +226,9 @@ public:
 	LitColor(const uint32_t rgba, const bool usesAlpha = true) : LitColor()
 	{
 		_rgba = rgba;
+		generateIntFromRgba();
 		generateRgb565FromInt();
 		generateRgb5A3FromInt(usesAlpha);
-		generateIntFromRgba();
 		generateFloatFromInt();
 		_useAlpha = usesAlpha;
 		_typeSelect = usesAlpha ? RGBA8888 : RGB888;
@@ -242,15 +244,17 @@ public:
 			case RGB5A3: {
 				_rgb5A3 = val;
 				generateIntFromRgb5A3(); //this sets alpha flag
+				generateRgb565FromInt();
 			} break;
 			default: {//RGB565
 				_rgb565 = val;
 				_useAlpha = false;
 				generateIntFromRgb565();
+				generateRgb5A3FromInt(false);
 			}
 		}
 
-		generateIntFromRgba();
+		generateRgbaFromInt();
 		generateFloatFromInt();
 	}
 
@@ -386,7 +390,8 @@ public:
 		RGBF,
 		RGBAF,
 		RGB565,
-		RGB5A3
+		RGB5A3,
+		RGBA16F
 		//RGB332,
 		//RGB444,
 		//RGB555,
@@ -423,7 +428,7 @@ public:
 		_typeSelect = type;
 
 		if (type != RGB5A3)
-			_useAlpha = (type == RGBA8888 || type == RGBAF) ? true : false;
+			_useAlpha = (type == RGBA8888 || type == RGBAF || type == RGBA16F) ? true : false;
 		else
 			_useAlpha = optionalAlphaFlag;
 	}
@@ -1036,17 +1041,82 @@ public:
 		return  alpha | (blue << 8) | (green << 16) | (red << 24);
 	}
 
+	//rounds to the nearest 8 bit value, clamps to 0 - 255 and maps NaN to 0
+	static int32_t FloatToChannel(const float value)
+	{
+		if (!(value > 0.0f))
+			return 0;
+
+		if (value >= 1.0f)
+			return 0xFF;
+
+		return static_cast<int32_t>(value * 255.0f + 0.5f);
+	}
+
 	static uint32_t RGBFToRGB888(const float* rgbf, const uint8_t alpha = 0xFF)
 	{
-		uint32_t red = static_cast<uint32_t>(rgbf[0] * 255.0f);
-		uint32_t green = static_cast<uint32_t>(rgbf[1] * 255.0f);
-		uint32_t blue = static_cast<uint32_t>(rgbf[2] * 255.0f);
+		uint32_t red = FloatToChannel(rgbf[0]);
+		uint32_t green = FloatToChannel(rgbf[1]);
+		uint32_t blue = FloatToChannel(rgbf[2]);
 		return  alpha | (blue << 8) | (green << 16) | (red << 24);
 	}
 
 	static uint32_t RGBAFToRGBA8888(const float* rgbaf)
 	{
-		return  RGBFToRGB888(rgbaf, 0) | static_cast<uint32_t>(rgbaf[3] * 255.0f);
+		return  RGBFToRGB888(rgbaf, 0) | static_cast<uint32_t>(FloatToChannel(rgbaf[3]));
+	}
+
+	//IEEE 754 half precision, no F16C required
+	static float HalfToFloat(const uint16_t half)
+	{
+		uint32_t bits = static_cast<uint32_t>(half & 0x7FFF) << 13;
+		const uint32_t exponent = bits & 0x0F800000;
+		bits += 0x38000000; //rebias exponent from 15 to 127
+
+		if (exponent == 0x0F800000) //inf, NaN
+			bits += 0x38000000;
+		else if (exponent == 0) //zero, subnormal
+		{
+			float val;
+			bits += 0x00800000;
+			std::memcpy(&val, &bits, sizeof(val));
+			val -= 6.103515625e-05f; //2^-14
+			std::memcpy(&bits, &val, sizeof(bits));
+		}
+
+		bits |= static_cast<uint32_t>(half & 0x8000) << 16;
+		float result;
+		std::memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+
+	//rounds to nearest even, overflows to inf, NaN stays NaN
+	static uint16_t FloatToHalf(const float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+		bits &= 0x7FFFFFFF;
+
+		if (bits >= 0x47800000) //65520 and above
+			return static_cast<uint16_t>(sign | (bits > 0x7F800000 ? 0x7E00 : 0x7C00));
+
+		if (bits < 0x38800000) //below 2^-14, the float addition does the rounding
+		{
+			float val;
+			std::memcpy(&val, &bits, sizeof(val));
+			val += 0.5f;
+			std::memcpy(&bits, &val, sizeof(bits));
+			return static_cast<uint16_t>(sign | (bits - 0x3F000000));
+		}
+
+		return static_cast<uint16_t>(sign | ((bits + 0xC8000FFF + ((bits >> 13) & 1)) >> 13));
+	}
+
+	static uint32_t RGBA16FToRGBA8888(const uint16_t* rgba16f)
+	{
+		const float channels[4] = { HalfToFloat(rgba16f[0]), HalfToFloat(rgba16f[1]), HalfToFloat(rgba16f[2]), HalfToFloat(rgba16f[3]) };
+		return RGBAFToRGBA8888(channels);
 	}
 
 	static uint32_t RGB5A3ToRGBA8888(const uint16_t rgb5a3)
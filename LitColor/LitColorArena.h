@@ -0,0 +1,217 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+//a block of memory backed by huge pages where the system provides them. Move only
+class LitColorPageBuffer
+{
+private:
+	static constexpr size_t HUGE_PAGE_SIZE = 0x200000;
+
+	uint8_t* _data = nullptr;
+	size_t _size = 0;
+	bool _mapped = false;
+	bool _hugePages = false;
+
+	void release()
+	{
+		if (!_data)
+			return;
+
+#ifdef __linux__
+		if (_mapped)
+			munmap(_data, _size);
+		else
+#endif
+			::operator delete(_data, std::align_val_t(HUGE_PAGE_SIZE));
+
+		_data = nullptr;
+		_size = 0;
+	}
+
+public:
+	LitColorPageBuffer() {}
+
+	//size is rounded up to whole huge pages
+	LitColorPageBuffer(const size_t size)
+	{
+		_size = std::max<size_t>((size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE, HUGE_PAGE_SIZE);
+
+#ifdef __linux__
+		//reserved huge pages first, then transparent huge pages
+		void* mapping = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		_hugePages = mapping != MAP_FAILED;
+
+		if (mapping == MAP_FAILED)
+			mapping = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (mapping != MAP_FAILED)
+		{
+			_data = static_cast<uint8_t*>(mapping);
+			_mapped = true;
+
+			if (!_hugePages)
+				_hugePages = madvise(_data, _size, MADV_HUGEPAGE) == 0;
+
+			return;
+		}
+#endif
+
+		_data = static_cast<uint8_t*>(::operator new(_size, std::align_val_t(HUGE_PAGE_SIZE)));
+	}
+
+	LitColorPageBuffer(LitColorPageBuffer&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	LitColorPageBuffer& operator=(LitColorPageBuffer&& other) noexcept
+	{
+		if (this != &other)
+		{
+			release();
+			std::swap(_data, other._data);
+			std::swap(_size, other._size);
+			std::swap(_mapped, other._mapped);
+			std::swap(_hugePages, other._hugePages);
+		}
+
+		return *this;
+	}
+
+	LitColorPageBuffer(const LitColorPageBuffer&) = delete;
+	LitColorPageBuffer& operator=(const LitColorPageBuffer&) = delete;
+
+	~LitColorPageBuffer()
+	{
+		release();
+	}
+
+	uint8_t* GetData() const
+	{
+		return _data;
+	}
+
+	size_t GetSize() const
+	{
+		return _size;
+	}
+
+	//true if huge pages were reserved or requested through madvise
+	bool UsesHugePages() const
+	{
+		return _hugePages;
+	}
+};
+
+//bump allocator. Allocations are never freed one by one, Reset() and Rewind() drop them all at once
+class LitColorArena
+{
+private:
+	std::vector<LitColorPageBuffer> _blocks;
+	size_t _blockSize = 0x4000000;
+	size_t _block = 0;
+	size_t _offset = 0;
+	size_t _lastOffset = 0;
+
+public:
+	struct Marker
+	{
+		size_t Block = 0;
+		size_t Offset = 0;
+	};
+
+	LitColorArena(const size_t blockSize = 0x4000000) : _blockSize(blockSize) {}
+
+	void* Allocate(const size_t size, const size_t alignment = alignof(std::max_align_t))
+	{
+		while (_block < _blocks.size())
+		{
+			const size_t offset = (_offset + alignment - 1) / alignment * alignment;
+
+			if (offset + size <= _blocks[_block].GetSize())
+			{
+				_lastOffset = offset;
+				_offset = offset + size;
+				return _blocks[_block].GetData() + offset;
+			}
+
+			++_block;
+			_offset = 0;
+		}
+
+		//blocks stay allocated after a reset and are reused by later allocations
+		_blocks.emplace_back(std::max(_blockSize, size));
+		_block = _blocks.size() - 1;
+		_lastOffset = 0;
+		_offset = size;
+		return _blocks.back().GetData();
+	}
+
+	template<typename T> T* Allocate(const size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "arena memory is released without running destructors");
+		return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+	}
+
+	//shrinks the most recent allocation so the space behind it is handed out again
+	void Shrink(const void* allocation, const size_t size)
+	{
+		if (_block < _blocks.size() && allocation == _blocks[_block].GetData() + _lastOffset)
+			_offset = _lastOffset + size;
+	}
+
+	Marker GetMarker() const
+	{
+		return { _block, _offset };
+	}
+
+	//releases everything allocated since marker was taken
+	void Rewind(const Marker& marker)
+	{
+		_block = marker.Block;
+		_offset = marker.Offset;
+		_lastOffset = marker.Offset;
+	}
+
+	void Reset()
+	{
+		Rewind(Marker());
+	}
+
+	//releases the blocks themselves as well
+	void Release()
+	{
+		_blocks.clear();
+		Reset();
+	}
+
+	size_t GetUsedBytes() const
+	{
+		size_t used = _offset;
+
+		for (size_t i = 0; i < _block && i < _blocks.size(); ++i)
+			used += _blocks[i].GetSize();
+
+		return used;
+	}
+
+	size_t GetReservedBytes() const
+	{
+		size_t reserved = 0;
+
+		for (const auto& block : _blocks)
+			reserved += block.GetSize();
+
+		return reserved;
+	}
+};
@@ -0,0 +1,184 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <vector>
+#include "LitColorScanner.h"
+
+struct LitColorArrayHit
+{
+	uint64_t Address = 0;
+	uint64_t RecordAddress = 0;
+	uint64_t RecordCount = 0;
+	size_t Stride = 0;
+	int Type = LitColor::RGBA8888;
+};
+
+class LitColorArrayScanner
+{
+private:
+	struct Run
+	{
+		uint64_t Start = 0;
+		uint64_t Length = 0;
+		uint32_t FirstWord = 0;
+		uint32_t LastRgba = 0;
+		bool Distinct = false;
+		bool Required = false;
+	};
+
+	int _type = LitColor::RGBA8888;
+	bool _bigEndian = true;
+	size_t _stride = 16;
+	size_t _fieldOffset = 0;
+	uint64_t _minRecords = 4;
+	uint32_t _alignment = 4;
+	int _maxStep = 16;
+	LitColorQuery _loader;
+	std::optional<LitColorQuery> _requiredQuery;
+
+	//integer formats, where every bit pattern is a valid color
+	template<int Type> static constexpr bool isPacked()
+	{
+		return Type == LitColor::RGB888 || Type == LitColor::RGBA8888 || Type == LitColor::RGB565 || Type == LitColor::RGB5A3;
+	}
+
+	template<int Type> static uint32_t toRgba(const uint32_t word)
+	{
+		if constexpr (Type == LitColor::RGB565)
+			return LitColor::RGB565ToRGB888(static_cast<uint16_t>(word));
+		else if constexpr (Type == LitColor::RGB5A3)
+			return word & 0x8000 ? LitColor::RGB5A3ToRGB888(static_cast<uint16_t>(word)) | 0xFF : LitColor::RGB5A3ToRGBA8888(static_cast<uint16_t>(word));
+		else
+			return word;
+	}
+
+	bool isStep(const uint32_t previous, const uint32_t rgba) const
+	{
+		for (int shift = 0; shift < 32; shift += 8)
+			if (std::abs(static_cast<int>((previous >> shift) & 0xFF) - static_cast<int>((rgba >> shift) & 0xFF)) > _maxStep)
+				return false;
+
+		return true;
+	}
+
+	void closeRun(Run& run, const uint64_t baseAddress, const size_t phase, std::vector<LitColorArrayHit>& hits) const
+	{
+		const uint64_t address = baseAddress + run.Start;
+		const bool anyField = _fieldOffset == ANY_FIELD_OFFSET;
+
+		//runs of a single repeated value are mostly zero-filled or cleared memory
+		if (run.Length >= _minRecords && run.Distinct && (run.Required || !_requiredQuery) && (anyField || address >= _fieldOffset))
+			hits.push_back({ address, address - (anyField ? phase : _fieldOffset), run.Length, _stride, _type });
+
+		run.Length = 0;
+	}
+
+	template<int Type> void scan(const uint8_t* data, const size_t size, const uint64_t baseAddress, std::vector<LitColorArrayHit>& hits) const
+	{
+		const size_t typeSize = LitColorScanner::GetTypeSize(Type);
+		const bool anyField = _fieldOffset == ANY_FIELD_OFFSET;
+
+		if (!anyField && _fieldOffset + typeSize > _stride)
+			return;
+
+		//a phase is an aligned offset within the stride, its fields sit at phase + n * stride from data. Without a field offset
+		//records are assumed to start at multiples of the stride, so the field has to fit behind the phase
+		const size_t phaseCount = anyField ? (_stride - typeSize) / _alignment + 1 : (_stride + _alignment - 1) / _alignment;
+		std::vector<Run> runs(phaseCount);
+
+		//walks the buffer record by record and advances every phase within a record, so memory is read front to back exactly once
+		for (size_t recordStart = 0; recordStart < size; recordStart += _stride)
+		{
+			for (size_t phase = 0; phase < phaseCount; ++phase)
+			{
+				Run& run = runs[phase];
+				const size_t offset = recordStart + phase * _alignment;
+				uint32_t word;
+				const bool valid = offset + typeSize <= size && _loader.LoadWord<Type>(data + offset, word);
+
+				if (!valid)
+				{
+					closeRun(run, baseAddress, phase * _alignment, hits);
+					continue;
+				}
+
+				//any bits are a valid packed color, so arrays of those have to change in small steps to tell them from random data
+				if constexpr (isPacked<Type>())
+				{
+					const uint32_t rgba = toRgba<Type>(word);
+
+					if (run.Length > 0 && !isStep(run.LastRgba, rgba))
+						closeRun(run, baseAddress, phase * _alignment, hits);
+
+					run.LastRgba = rgba;
+				}
+
+				if (run.Length == 0)
+				{
+					run.Start = offset;
+					run.FirstWord = word;
+					run.Distinct = false;
+					run.Required = false;
+				}
+				else if (word != run.FirstWord)
+					run.Distinct = true;
+
+				if (_requiredQuery && !run.Required)
+					run.Required = _requiredQuery->Matches<Type>(data + offset);
+
+				++run.Length;
+			}
+		}
+
+		for (size_t phase = 0; phase < phaseCount; ++phase)
+			closeRun(runs[phase], baseAddress, phase * _alignment, hits);
+	}
+
+public:
+	//scans every aligned position within the stride
+	static constexpr size_t ANY_FIELD_OFFSET = SIZE_MAX;
+
+	LitColorArrayScanner(const int type, const size_t stride, const size_t fieldOffset = ANY_FIELD_OFFSET, const uint64_t minRecords = 4, const bool bigEndian = true, const uint32_t alignment = 4)
+		: _type(type), _bigEndian(bigEndian), _stride(std::max(stride, LitColorScanner::GetTypeSize(type))), _fieldOffset(fieldOffset),
+		_minRecords(std::max<uint64_t>(minRecords, 2)), _alignment(alignment ? alignment : 1), _loader(LitColor(), type, LitColorQuery::EXACT, bigEndian)
+	{}
+
+	//only report arrays with at least one record matching query
+	void SetRequiredQuery(const LitColorQuery& query)
+	{
+		_requiredQuery = query;
+	}
+
+	void ClearRequiredQuery()
+	{
+		_requiredQuery.reset();
+	}
+
+	//largest change of any 8 bit channel between neighbouring records of packed integer formats, default 16. 255 accepts any data
+	void SetMaxStep(const int maxStep)
+	{
+		_maxStep = maxStep;
+	}
+
+	//Address is the first record's color, RecordAddress the start of that record
+	std::vector<LitColorArrayHit> Scan(const uint8_t* data, const size_t size, const uint64_t baseAddress = 0) const
+	{
+		std::vector<LitColorArrayHit> hits;
+
+		switch (_type)
+		{
+		case LitColor::RGB888: scan<LitColor::RGB888>(data, size, baseAddress, hits); break;
+		case LitColor::RGBA8888: scan<LitColor::RGBA8888>(data, size, baseAddress, hits); break;
+		case LitColor::RGBF: scan<LitColor::RGBF>(data, size, baseAddress, hits); break;
+		case LitColor::RGBAF: scan<LitColor::RGBAF>(data, size, baseAddress, hits); break;
+		case LitColor::RGBA16F: scan<LitColor::RGBA16F>(data, size, baseAddress, hits); break;
+		case LitColor::RGB5A3: scan<LitColor::RGB5A3>(data, size, baseAddress, hits); break;
+		default: scan<LitColor::RGB565>(data, size, baseAddress, hits);
+		}
+
+		std::sort(hits.begin(), hits.end(), [](const LitColorArrayHit& a, const LitColorArrayHit& b) { return a.Address < b.Address; });
+		return hits;
+	}
+};
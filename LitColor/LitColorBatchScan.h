@@ -0,0 +1,249 @@
+﻿#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "LitColorScanner.h"
+
+struct LitColorDumpResult
+{
+	std::string Path;
+	std::vector<LitColorHit> Hits;
+	bool Success = false;
+};
+
+class LitColorBatchScan
+{
+private:
+	//a chunk of one dump. The buffer starts with the tail of the previous chunk, so values crossing the boundary are found
+	struct Job
+	{
+		size_t Dump;
+		size_t Buffer;
+		uint64_t Offset; //position of the buffer's first byte within the dump
+		size_t Size;
+		size_t End; //scan positions before End, the rest is carried into the next chunk
+		size_t NewBytes;
+	};
+
+	struct DumpState
+	{
+		std::mutex Mutex;
+		uint64_t Size = 0;
+		uint64_t ScannedBytes = 0;
+		bool Failed = false;
+	};
+
+	static constexpr size_t END_OF_JOBS = static_cast<size_t>(-1);
+
+	LitColorScanner _scanner;
+	uint64_t _baseAddress = 0;
+	unsigned int _threadCount = 0;
+	size_t _bufferCount = 0;
+	size_t _chunkSize = 0x400000;
+
+	//bytes of a chunk scanned again with the next one, the most that fits before a value reaching into the next chunk
+	size_t getCarrySize() const
+	{
+		const size_t alignment = _scanner.GetAlignment();
+		return (_scanner.GetValueSize() - 1) / alignment * alignment;
+	}
+
+public:
+	LitColorBatchScan(const LitColorScanner& scanner, const uint64_t baseAddress = 0, const unsigned int threadCount = 0, const size_t bufferCount = 0)
+		: _scanner(scanner), _baseAddress(baseAddress), _threadCount(threadCount), _bufferCount(bufferCount)
+	{
+		if (_threadCount == 0)
+			_threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		//one buffer per worker plus one being filled by the reader
+		if (_bufferCount == 0)
+			_bufferCount = _threadCount + 1;
+
+		SetChunkSize(_chunkSize);
+	}
+
+	//bytes read per chunk, default 4 MiB. Memory stays bounded by bufferCount chunks however large the dumps are
+	void SetChunkSize(const size_t chunkSize)
+	{
+		const size_t alignment = _scanner.GetAlignment();
+		_chunkSize = std::max<size_t>((std::max<size_t>(chunkSize, 0x1000) + alignment - 1) / alignment * alignment, getCarrySize() + alignment);
+	}
+
+	size_t GetChunkSize() const
+	{
+		return _chunkSize;
+	}
+
+	std::vector<LitColorDumpResult> Run(const std::vector<std::string>& paths, std::shared_ptr<LitColorScanProgress> progress = nullptr) const
+	{
+		std::vector<LitColorDumpResult> results(paths.size());
+		std::vector<DumpState> dumps(paths.size());
+		const size_t carrySize = getCarrySize();
+		uint64_t total = 0;
+		uint64_t chunkCount = 0;
+
+		for (size_t i = 0; i < paths.size(); ++i)
+		{
+			std::error_code error;
+			const uint64_t size = std::filesystem::file_size(paths[i], error);
+			dumps[i].Size = error ? 0 : size;
+			dumps[i].Failed = static_cast<bool>(error);
+			total += dumps[i].Size;
+			chunkCount += (dumps[i].Size + _chunkSize - 1) / _chunkSize;
+			results[i].Path = paths[i];
+		}
+
+		if (progress)
+			progress->Reset(total);
+
+		//chunks of one dump are scanned in parallel, so a few large dumps still keep every thread busy
+		const unsigned int workerCount = static_cast<unsigned int>(std::max<uint64_t>(1, std::min<uint64_t>(_threadCount, chunkCount)));
+		std::vector<std::vector<uint8_t>> buffers(std::max<size_t>(std::min<uint64_t>(_bufferCount, chunkCount), 1));
+		std::deque<size_t> freeBuffers;
+		std::deque<Job> jobs;
+		std::mutex mutex;
+		std::condition_variable bufferReleased;
+		std::condition_variable jobQueued;
+
+		for (size_t i = 0; i < buffers.size(); ++i)
+			freeBuffers.push_back(i);
+
+		//reads ahead into free buffers while the workers scan the filled ones
+		std::thread reader([&]()
+		{
+			std::vector<uint8_t> carry;
+
+			for (size_t dump = 0; dump < paths.size(); ++dump)
+			{
+				DumpState& state = dumps[dump];
+				std::ifstream file(paths[dump], std::ios::binary);
+				uint64_t position = 0;
+				carry.clear();
+
+				if (!file)
+					state.Failed = true;
+
+				while (!state.Failed && position < state.Size && !(progress && progress->IsCancelled()))
+				{
+					size_t buffer;
+
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						bufferReleased.wait(lock, [&]() { return !freeBuffers.empty(); });
+						buffer = freeBuffers.front();
+						freeBuffers.pop_front();
+					}
+
+					std::vector<uint8_t>& data = buffers[buffer];
+					const size_t chunk = static_cast<size_t>(std::min<uint64_t>(_chunkSize, state.Size - position));
+					data.resize(carry.size() + chunk);
+					std::copy(carry.begin(), carry.end(), data.begin());
+					file.read(reinterpret_cast<char*>(data.data() + carry.size()), static_cast<std::streamsize>(chunk));
+
+					if (static_cast<size_t>(file.gcount()) != chunk)
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						state.Failed = true;
+						freeBuffers.push_back(buffer);
+						break;
+					}
+
+					const bool last = position + chunk == state.Size;
+					const Job job = { dump, buffer, position - carry.size(), data.size(), last ? data.size() : data.size() - carrySize, chunk };
+					carry.assign(data.end() - static_cast<std::ptrdiff_t>(std::min(carrySize, data.size())), data.end());
+					position += chunk;
+
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						jobs.push_back(job);
+					}
+
+					jobQueued.notify_one();
+				}
+
+				//bytes that will never be scanned still count, so progress reaches 100%
+				if (progress && state.Failed)
+					progress->AddBytesProcessed(state.Size - position);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				for (unsigned int i = 0; i < workerCount; ++i)
+					jobs.push_back({ END_OF_JOBS, 0, 0, 0, 0, 0 });
+			}
+
+			jobQueued.notify_all();
+		});
+
+		auto worker = [&]()
+		{
+			std::vector<LitColorHit> hits;
+
+			while (true)
+			{
+				Job job;
+
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					jobQueued.wait(lock, [&]() { return !jobs.empty(); });
+					job = jobs.front();
+					jobs.pop_front();
+				}
+
+				if (job.Dump == END_OF_JOBS)
+					return;
+
+				if (!progress || !progress->IsCancelled())
+				{
+					hits.clear();
+					_scanner.ScanRange(buffers[job.Buffer].data(), job.Size, 0, job.End, _baseAddress + job.Offset, hits);
+					DumpState& state = dumps[job.Dump];
+					std::lock_guard<std::mutex> lock(state.Mutex);
+					results[job.Dump].Hits.insert(results[job.Dump].Hits.end(), hits.begin(), hits.end());
+					state.ScannedBytes += job.NewBytes;
+				}
+
+				if (progress)
+					progress->AddBytesProcessed(job.NewBytes);
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					freeBuffers.push_back(job.Buffer);
+				}
+
+				bufferReleased.notify_one();
+			}
+		};
+
+		std::vector<std::thread> workers;
+
+		for (unsigned int i = 0; i < workerCount; ++i)
+			workers.emplace_back(worker);
+
+		reader.join();
+
+		for (auto& thread : workers)
+			thread.join();
+
+		for (size_t i = 0; i < paths.size(); ++i)
+		{
+			std::sort(results[i].Hits.begin(), results[i].Hits.end());
+			results[i].Success = !dumps[i].Failed && dumps[i].ScannedBytes == dumps[i].Size;
+		}
+
+		if (progress)
+			progress->SetFinished();
+
+		return results;
+	}
+
+	std::future<std::vector<LitColorDumpResult>> RunAsync(const std::vector<std::string>& paths, std::shared_ptr<LitColorScanProgress> progress = nullptr) const
+	{
+		const LitColorBatchScan batch = *this;
+		return std::async(std::launch::async, [batch, paths, progress]() { return batch.Run(paths, progress); });
+	}
+};
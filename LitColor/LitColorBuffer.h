@@ -0,0 +1,549 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include "LitColor.h"
+
+template<typename T, size_t Alignment = 64> class LitColorAlignedAllocator
+{
+public:
+	using value_type = T;
+
+	template<typename U> struct rebind
+	{
+		using other = LitColorAlignedAllocator<U, Alignment>;
+	};
+
+	LitColorAlignedAllocator() = default;
+
+	template<typename U> LitColorAlignedAllocator(const LitColorAlignedAllocator<U, Alignment>&) {}
+
+	T* allocate(const size_t count)
+	{
+		const size_t bytes = (count * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+		void* ptr = ::operator new(bytes, std::align_val_t(Alignment));
+		return static_cast<T*>(ptr);
+	}
+
+	void deallocate(T* ptr, const size_t)
+	{
+		::operator delete(ptr, std::align_val_t(Alignment));
+	}
+
+	template<typename U> bool operator==(const LitColorAlignedAllocator<U, Alignment>&) const
+	{
+		return true;
+	}
+
+	template<typename U> bool operator!=(const LitColorAlignedAllocator<U, Alignment>&) const
+	{
+		return false;
+	}
+};
+
+class LitColorBuffer
+{
+public:
+	template<typename T> using Plane = std::vector<T, LitColorAlignedAllocator<T>>;
+
+private:
+	Plane<uint8_t> _channels[4];
+	mutable Plane<uint32_t> _rgba;
+	mutable Plane<uint16_t> _rgb565;
+	mutable Plane<uint16_t> _rgb5A3;
+	mutable Plane<float> _floats[4];
+	mutable bool _rgbaValid = false;
+	mutable bool _rgb565Valid = false;
+	mutable bool _rgb5A3Valid = false;
+	mutable bool _floatsValid = false;
+	bool _useAlpha = true;
+
+	void invalidate()
+	{
+		_rgbaValid = false;
+		_rgb565Valid = false;
+		_rgb5A3Valid = false;
+		_floatsValid = false;
+	}
+
+	static uint8_t clampChannel(const int32_t val)
+	{
+		return static_cast<uint8_t>(val < 0 ? 0 : (val > 0xFF ? 0xFF : val));
+	}
+
+	static size_t typeSize(const int type)
+	{
+		switch (type)
+		{
+		case LitColor::RGB888: return 3;
+		case LitColor::RGBA8888: return 4;
+		case LitColor::RGBF: return 12;
+		case LitColor::RGBAF: return 16;
+		case LitColor::RGBA16F: return 8;
+		default: return 2; //RGB565, RGB5A3
+		}
+	}
+
+	static bool isHostBigEndian()
+	{
+		const uint16_t probe = 1;
+		return *reinterpret_cast<const uint8_t*>(&probe) == 0;
+	}
+
+	//unsigned integers of 2 or 4 bytes, floats go through their bits
+	template<typename T> static T readValue(const uint8_t* ptr, const bool bigEndian)
+	{
+		using Raw = std::conditional_t<sizeof(T) == 2, uint16_t, uint32_t>;
+		Raw raw;
+		std::memcpy(&raw, ptr, sizeof(raw));
+
+		if (bigEndian != isHostBigEndian())
+			raw = sizeof(T) == 2 ? static_cast<Raw>((raw >> 8) | (raw << 8)) : static_cast<Raw>((raw >> 24) | ((raw >> 8) & 0xFF00) | ((raw << 8) & 0xFF0000) | (raw << 24));
+
+		T val;
+		std::memcpy(&val, &raw, sizeof(val));
+		return val;
+	}
+
+	template<typename T> static void writeValue(uint8_t* ptr, const T val, const bool bigEndian)
+	{
+		using Raw = std::conditional_t<sizeof(T) == 2, uint16_t, uint32_t>;
+		Raw raw;
+		std::memcpy(&raw, &val, sizeof(raw));
+
+		if (bigEndian != isHostBigEndian())
+			raw = sizeof(T) == 2 ? static_cast<Raw>((raw >> 8) | (raw << 8)) : static_cast<Raw>((raw >> 24) | ((raw >> 8) & 0xFF00) | ((raw << 8) & 0xFF0000) | (raw << 24));
+
+		std::memcpy(ptr, &raw, sizeof(raw));
+	}
+
+public:
+	LitColorBuffer(const bool usesAlpha = true) : _useAlpha(usesAlpha) {}
+
+	LitColorBuffer(const size_t count, const LitColor& color) : _useAlpha(color.UsesAlpha())
+	{
+		Resize(count);
+		Fill(color);
+	}
+
+	size_t GetSize() const
+	{
+		return _channels[LitColor::RED].size();
+	}
+
+	bool UsesAlpha() const
+	{
+		return _useAlpha;
+	}
+
+	void SetUseAlpha(const bool shallI)
+	{
+		_useAlpha = shallI;
+		_rgb5A3Valid = false;
+	}
+
+	void Resize(const size_t count)
+	{
+		for (auto& channel : _channels)
+			channel.resize(count, 0xFF);
+
+		invalidate();
+	}
+
+	void Clear()
+	{
+		Resize(0);
+	}
+
+	void Reserve(const size_t count)
+	{
+		for (auto& channel : _channels)
+			channel.reserve(count);
+	}
+
+	void PushBack(LitColor color)
+	{
+		for (int i = LitColor::RED; i <= LitColor::ALPHA; ++i)
+			_channels[i].push_back(clampChannel(color.GetColorValue<int32_t>(i)));
+
+		invalidate();
+	}
+
+	void Fill(LitColor color)
+	{
+		for (int i = LitColor::RED; i <= LitColor::ALPHA; ++i)
+			std::fill(_channels[i].begin(), _channels[i].end(), clampChannel(color.GetColorValue<int32_t>(i)));
+
+		invalidate();
+	}
+
+	LitColor Get(const size_t index) const
+	{
+		LitColor color(static_cast<int32_t>(_channels[LitColor::RED][index]), static_cast<int32_t>(_channels[LitColor::GREEN][index]),
+			static_cast<int32_t>(_channels[LitColor::BLUE][index]), static_cast<int32_t>(_channels[LitColor::ALPHA][index]), _useAlpha);
+		color.SetUseAlpha(_useAlpha);
+		return color;
+	}
+
+	void Set(const size_t index, LitColor color)
+	{
+		for (int i = LitColor::RED; i <= LitColor::ALPHA; ++i)
+			_channels[i][index] = clampChannel(color.GetColorValue<int32_t>(i));
+
+		invalidate();
+	}
+
+	void LoadRGBA8888(const uint32_t* rgba, const size_t count)
+	{
+		Resize(count);
+		uint8_t* r = _channels[LitColor::RED].data();
+		uint8_t* g = _channels[LitColor::GREEN].data();
+		uint8_t* b = _channels[LitColor::BLUE].data();
+		uint8_t* a = _channels[LitColor::ALPHA].data();
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			r[i] = static_cast<uint8_t>(rgba[i] >> 24);
+			g[i] = static_cast<uint8_t>(rgba[i] >> 16);
+			b[i] = static_cast<uint8_t>(rgba[i] >> 8);
+			a[i] = static_cast<uint8_t>(rgba[i]);
+		}
+	}
+
+	//decodes count values of type stored back to back, e.g. a texture or palette. Float channels are clamped and rounded like LitColor does
+	void LoadFromMemory(const uint8_t* data, const size_t count, const int type, const bool bigEndian = true)
+	{
+		Resize(count);
+		const size_t size = typeSize(type);
+		_useAlpha = type == LitColor::RGBA8888 || type == LitColor::RGBAF || type == LitColor::RGB5A3 || type == LitColor::RGBA16F;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint8_t* ptr = data + i * size;
+			uint8_t rgba[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+
+			switch (type)
+			{
+			case LitColor::RGB888:
+				std::copy(ptr, ptr + 3, rgba);
+				break;
+			case LitColor::RGBA8888:
+				std::copy(ptr, ptr + 4, rgba);
+
+				if (!bigEndian)
+					std::reverse(rgba, rgba + 4);
+				break;
+			case LitColor::RGBF:
+			case LitColor::RGBAF:
+				for (int c = 0; c < (type == LitColor::RGBAF ? 4 : 3); ++c)
+					rgba[c] = static_cast<uint8_t>(LitColor::FloatToChannel(readValue<float>(ptr + c * sizeof(float), bigEndian)));
+				break;
+			case LitColor::RGBA16F:
+				for (int c = 0; c < 4; ++c)
+					rgba[c] = static_cast<uint8_t>(LitColor::FloatToChannel(LitColor::HalfToFloat(readValue<uint16_t>(ptr + c * sizeof(uint16_t), bigEndian))));
+				break;
+			case LitColor::RGB5A3: {
+				const uint16_t word = readValue<uint16_t>(ptr, bigEndian);
+				const uint32_t expanded = (word & 0x8000) ? (LitColor::RGB5A3ToRGB888(word) | 0xFF) : LitColor::RGB5A3ToRGBA8888(word);
+
+				for (int c = 0; c < 4; ++c)
+					rgba[c] = static_cast<uint8_t>(expanded >> (24 - c * 8));
+			} break;
+			default: {
+				const uint32_t expanded = LitColor::RGB565ToRGB888(readValue<uint16_t>(ptr, bigEndian));
+
+				for (int c = 0; c < 4; ++c)
+					rgba[c] = static_cast<uint8_t>(expanded >> (24 - c * 8));
+			}
+			}
+
+			for (int c = LitColor::RED; c <= LitColor::ALPHA; ++c)
+				_channels[c][i] = rgba[c];
+		}
+	}
+
+	const Plane<uint8_t>& GetChannel(const int colorIndicator) const
+	{
+		return _channels[colorIndicator];
+	}
+
+	//direct write access, any cached plane is rebuilt on its next request
+	uint8_t* EditChannel(const int colorIndicator)
+	{
+		invalidate();
+		return _channels[colorIndicator].data();
+	}
+
+	const Plane<uint32_t>& GetRGBA() const
+	{
+		if (_rgbaValid)
+			return _rgba;
+
+		const size_t count = GetSize();
+		const uint8_t* r = _channels[LitColor::RED].data();
+		const uint8_t* g = _channels[LitColor::GREEN].data();
+		const uint8_t* b = _channels[LitColor::BLUE].data();
+		const uint8_t* a = _channels[LitColor::ALPHA].data();
+		_rgba.resize(count);
+
+		for (size_t i = 0; i < count; ++i)
+			_rgba[i] = static_cast<uint32_t>(r[i]) << 24 | static_cast<uint32_t>(g[i]) << 16 | static_cast<uint32_t>(b[i]) << 8 | a[i];
+
+		_rgbaValid = true;
+		return _rgba;
+	}
+
+	const Plane<uint16_t>& GetRGB565() const
+	{
+		if (_rgb565Valid)
+			return _rgb565;
+
+		const size_t count = GetSize();
+		const uint8_t* r = _channels[LitColor::RED].data();
+		const uint8_t* g = _channels[LitColor::GREEN].data();
+		const uint8_t* b = _channels[LitColor::BLUE].data();
+		_rgb565.resize(count);
+
+		for (size_t i = 0; i < count; ++i)
+			_rgb565[i] = static_cast<uint16_t>((r[i] >> 3) << 11 | (g[i] >> 2) << 5 | (b[i] >> 3));
+
+		_rgb565Valid = true;
+		return _rgb565;
+	}
+
+	const Plane<uint16_t>& GetRGB5A3() const
+	{
+		if (_rgb5A3Valid)
+			return _rgb5A3;
+
+		const size_t count = GetSize();
+		const uint8_t* r = _channels[LitColor::RED].data();
+		const uint8_t* g = _channels[LitColor::GREEN].data();
+		const uint8_t* b = _channels[LitColor::BLUE].data();
+		const uint8_t* a = _channels[LitColor::ALPHA].data();
+		_rgb5A3.resize(count);
+
+		if (_useAlpha)
+		{
+			for (size_t i = 0; i < count; ++i)
+				_rgb5A3[i] = static_cast<uint16_t>((a[i] >> 5) << 12 | (r[i] >> 4) << 8 | (g[i] >> 4) << 4 | (b[i] >> 4));
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i)
+				_rgb5A3[i] = static_cast<uint16_t>(0x8000 | (r[i] >> 3) << 10 | (g[i] >> 3) << 5 | (b[i] >> 3));
+		}
+
+		_rgb5A3Valid = true;
+		return _rgb5A3;
+	}
+
+	const Plane<float>& GetFloatChannel(const int colorIndicator) const
+	{
+		if (_floatsValid)
+			return _floats[colorIndicator];
+
+		const size_t count = GetSize();
+
+		for (int c = LitColor::RED; c <= LitColor::ALPHA; ++c)
+		{
+			const uint8_t* src = _channels[c].data();
+			_floats[c].resize(count);
+			float* dst = _floats[c].data();
+
+			for (size_t i = 0; i < count; ++i)
+				dst[i] = static_cast<float>(src[i]) / 255.0f;
+		}
+
+		_floatsValid = true;
+		return _floats[colorIndicator];
+	}
+
+	template<typename T> void SetColorValue(T value, const int colorIndicator)
+	{
+		uint8_t channelValue;
+
+		if constexpr (std::is_floating_point_v<T>)
+			channelValue = static_cast<uint8_t>(LitColor::FloatToChannel(value));
+		else
+			channelValue = clampChannel(static_cast<int32_t>(value));
+
+		std::fill(_channels[colorIndicator].begin(), _channels[colorIndicator].end(), channelValue);
+		invalidate();
+	}
+
+	template<typename T> void SetColorValue(const size_t index, T value, const int colorIndicator)
+	{
+		if constexpr (std::is_floating_point_v<T>)
+			_channels[colorIndicator][index] = static_cast<uint8_t>(LitColor::FloatToChannel(value));
+		else
+			_channels[colorIndicator][index] = clampChannel(static_cast<int32_t>(value));
+
+		invalidate();
+	}
+
+	//saturating per channel arithmetic like LitColor's operators, applied to every color
+	void Add(LitColor color)
+	{
+		for (int c = LitColor::RED; c <= LitColor::ALPHA; ++c)
+		{
+			const int32_t operand = color.GetColorValue<int32_t>(c);
+			uint8_t* channel = _channels[c].data();
+
+			for (size_t i = 0, count = GetSize(); i < count; ++i)
+				channel[i] = clampChannel(channel[i] + operand);
+		}
+
+		invalidate();
+	}
+
+	void Subtract(LitColor color)
+	{
+		for (int c = LitColor::RED; c <= LitColor::ALPHA; ++c)
+		{
+			const int32_t operand = color.GetColorValue<int32_t>(c);
+			uint8_t* channel = _channels[c].data();
+
+			for (size_t i = 0, count = GetSize(); i < count; ++i)
+				channel[i] = clampChannel(channel[i] - operand);
+		}
+
+		invalidate();
+	}
+
+	//rounds like LitColor's float path, through a table of all 256 results
+	void Multiply(const float factor, const bool includeAlpha = false)
+	{
+		uint8_t products[256];
+
+		for (int val = 0; val < 256; ++val)
+			products[val] = static_cast<uint8_t>(LitColor::FloatToChannel(static_cast<float>(val) / 255.0f * factor));
+
+		for (int c = LitColor::RED; c <= (includeAlpha ? LitColor::ALPHA : LitColor::BLUE); ++c)
+		{
+			uint8_t* channel = _channels[c].data();
+
+			for (size_t i = 0, count = GetSize(); i < count; ++i)
+				channel[i] = products[channel[i]];
+		}
+
+		invalidate();
+	}
+
+	//writes 1 into matches for every color equal to color, ignoring alpha unless color uses alpha
+	size_t CompareEqual(const LitColor& color, std::vector<uint8_t>& matches) const
+	{
+		const uint32_t mask = color.UsesAlpha() ? 0xFFFFFFFF : 0xFFFFFF00;
+		const uint32_t key = color.GetRGBA() & mask;
+		const Plane<uint32_t>& rgba = GetRGBA();
+		const size_t count = rgba.size();
+		size_t matchCount = 0;
+		matches.resize(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			matches[i] = (rgba[i] & mask) == key;
+			matchCount += matches[i];
+		}
+
+		return matchCount;
+	}
+
+	std::vector<size_t> FindEqual(const LitColor& color) const
+	{
+		std::vector<uint8_t> matches;
+		std::vector<size_t> indices;
+		indices.reserve(CompareEqual(color, matches));
+
+		for (size_t i = 0; i < matches.size(); ++i)
+			if (matches[i])
+				indices.push_back(i);
+
+		return indices;
+	}
+
+	//replaces every color equal to from, e.g. to recolor a palette
+	size_t Replace(const LitColor& from, LitColor to)
+	{
+		std::vector<uint8_t> matches;
+		const size_t matchCount = CompareEqual(from, matches);
+		uint8_t values[4];
+
+		for (int c = LitColor::RED; c <= LitColor::ALPHA; ++c)
+			values[c] = clampChannel(to.GetColorValue<int32_t>(c));
+
+		for (int c = LitColor::RED; c <= LitColor::ALPHA; ++c)
+		{
+			uint8_t* channel = _channels[c].data();
+
+			for (size_t i = 0; i < matches.size(); ++i)
+				channel[i] = matches[i] ? values[c] : channel[i];
+		}
+
+		invalidate();
+		return matchCount;
+	}
+
+	//encodes every color as type, back to back
+	void StoreToMemory(uint8_t* data, const int type, const bool bigEndian = true) const
+	{
+		const size_t count = GetSize();
+
+		switch (type)
+		{
+		case LitColor::RGB888: {
+			for (int c = LitColor::RED; c <= LitColor::BLUE; ++c)
+			{
+				const uint8_t* channel = _channels[c].data();
+
+				for (size_t i = 0; i < count; ++i)
+					data[i * 3 + c] = channel[i];
+			}
+		} break;
+		case LitColor::RGBA8888: {
+			const Plane<uint32_t>& rgba = GetRGBA();
+
+			for (size_t i = 0; i < count; ++i)
+				writeValue<uint32_t>(data + i * 4, rgba[i], bigEndian);
+		} break;
+		case LitColor::RGBF:
+		case LitColor::RGBAF: {
+			const int channelCount = type == LitColor::RGBAF ? 4 : 3;
+
+			for (int c = 0; c < channelCount; ++c)
+			{
+				const Plane<float>& channel = GetFloatChannel(c);
+
+				for (size_t i = 0; i < count; ++i)
+					writeValue<float>(data + (i * channelCount + c) * sizeof(float), channel[i], bigEndian);
+			}
+		} break;
+		case LitColor::RGBA16F: {
+			for (int c = LitColor::RED; c <= LitColor::ALPHA; ++c)
+			{
+				const Plane<float>& channel = GetFloatChannel(c);
+
+				for (size_t i = 0; i < count; ++i)
+					writeValue<uint16_t>(data + (i * 4 + c) * sizeof(uint16_t), LitColor::FloatToHalf(channel[i]), bigEndian);
+			}
+		} break;
+		case LitColor::RGB5A3: {
+			const Plane<uint16_t>& rgb5A3 = GetRGB5A3();
+
+			for (size_t i = 0; i < count; ++i)
+				writeValue<uint16_t>(data + i * 2, rgb5A3[i], bigEndian);
+		} break;
+		default: {
+			const Plane<uint16_t>& rgb565 = GetRGB565();
+
+			for (size_t i = 0; i < count; ++i)
+				writeValue<uint16_t>(data + i * 2, rgb565[i], bigEndian);
+		}
+		}
+	}
+};
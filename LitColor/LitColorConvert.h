@@ -0,0 +1,673 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "LitColor.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LITCOLOR_SSE2
+#include <emmintrin.h>
+#endif
+
+//bulk conversions between float, half float and 8 bit channels. Byte arrays hold the channels in memory order (R, G, B, A)
+class LitColorConvert
+{
+private:
+	static constexpr int SRGB_HINT_SHIFT = 15; //keeps the exponent and 8 mantissa bits
+
+	static const float* srgbDecodeTable()
+	{
+		static const auto table = []()
+		{
+			std::vector<float> values(256);
+
+			for (int i = 0; i < 256; ++i)
+			{
+				const float channel = static_cast<float>(i) / 255.0f;
+				values[i] = channel <= 0.04045f ? channel / 12.92f : std::pow((channel + 0.055f) / 1.055f, 2.4f);
+			}
+
+			return values;
+		}();
+
+		return table.data();
+	}
+
+	static float srgbEncodeCurve(const float linear)
+	{
+		return linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+	}
+
+	static float fromBits(const uint32_t bits)
+	{
+		float val;
+		std::memcpy(&val, &bits, sizeof(val));
+		return val;
+	}
+
+	//smallest linear value encoding to each byte, found by bisecting the bit patterns of the exact curve. Positive floats order like their bits
+	static const float* srgbEncodeThresholds()
+	{
+		static const auto table = []()
+		{
+			std::vector<float> values(257, 0.0f);
+			values[256] = INFINITY;
+
+			for (int i = 1; i < 256; ++i)
+			{
+				uint32_t low = 0;
+				uint32_t high = 0x3F800000;
+
+				while (low < high)
+				{
+					const uint32_t middle = low + (high - low) / 2;
+
+					if (LitColor::FloatToChannel(srgbEncodeCurve(fromBits(middle))) >= i)
+						high = middle;
+					else
+						low = middle + 1;
+				}
+
+				values[i] = fromBits(low);
+			}
+
+			return values;
+		}();
+
+		return table.data();
+	}
+
+	//the byte at the start of every range of floats sharing their top bits. A good start for the search in encodeSrgb()
+	static const uint8_t* srgbEncodeHints()
+	{
+		static const auto table = []()
+		{
+			const float* thresholds = srgbEncodeThresholds();
+			std::vector<uint8_t> values((0x3F800000 >> SRGB_HINT_SHIFT) + 1);
+			int channel = 0;
+
+			for (uint32_t i = 0; i < values.size(); ++i)
+			{
+				while (channel < 255 && fromBits(i << SRGB_HINT_SHIFT) >= thresholds[channel + 1])
+					++channel;
+
+				values[i] = static_cast<uint8_t>(channel);
+			}
+
+			return values;
+		}();
+
+		return table.data();
+	}
+
+	//same result as rounding the exact curve, the steep part near black included
+	static uint8_t encodeSrgb(const float linear)
+	{
+		if (!(linear > 0.0f))
+			return 0;
+
+		if (linear >= 1.0f)
+			return 0xFF;
+
+		uint32_t bits;
+		std::memcpy(&bits, &linear, sizeof(bits));
+		const float* thresholds = srgbEncodeThresholds();
+		int channel = srgbEncodeHints()[bits >> SRGB_HINT_SHIFT];
+
+		while (linear >= thresholds[channel + 1])
+			++channel;
+
+		return static_cast<uint8_t>(channel);
+	}
+
+	//hue as a fraction of a full turn, 0 for gray
+	static float hue(const float r, const float g, const float b, const float max, const float delta)
+	{
+		if (!(delta > 0.0f))
+			return 0.0f;
+
+		float h = max == r ? (g - b) / delta : (max == g ? 2.0f + (b - r) / delta : 4.0f + (r - g) / delta);
+		h /= 6.0f;
+		return h < 0.0f ? h + 1.0f : h;
+	}
+
+	static void rgbToHsv(const float* rgb, float* hsv)
+	{
+		const float max = std::max(rgb[0], std::max(rgb[1], rgb[2]));
+		const float delta = max - std::min(rgb[0], std::min(rgb[1], rgb[2]));
+		hsv[0] = hue(rgb[0], rgb[1], rgb[2], max, delta);
+		hsv[1] = max > 0.0f ? delta / max : 0.0f;
+		hsv[2] = max;
+	}
+
+	static void hsvToRgb(const float* hsv, float* rgb)
+	{
+		const float chroma = hsv[2] * hsv[1];
+		const float h = hsv[0] * 6.0f;
+		const float r = h + 5.0f, g = h + 3.0f, b = h + 1.0f;
+		const float k[3] = { r - 6.0f * std::floor(r / 6.0f), g - 6.0f * std::floor(g / 6.0f), b - 6.0f * std::floor(b / 6.0f) };
+
+		for (int i = 0; i < 3; ++i)
+			rgb[i] = hsv[2] - chroma * std::max(0.0f, std::min(std::min(k[i], 4.0f - k[i]), 1.0f));
+	}
+
+	static void rgbToHsl(const float* rgb, float* hsl)
+	{
+		const float max = std::max(rgb[0], std::max(rgb[1], rgb[2]));
+		const float min = std::min(rgb[0], std::min(rgb[1], rgb[2]));
+		const float delta = max - min;
+		const float divisor = 1.0f - std::fabs(max + min - 1.0f);
+		hsl[0] = hue(rgb[0], rgb[1], rgb[2], max, delta);
+		hsl[1] = delta > 0.0f && divisor > 0.0f ? delta / divisor : 0.0f;
+		hsl[2] = (max + min) * 0.5f;
+	}
+
+	static void hslToRgb(const float* hsl, float* rgb)
+	{
+		const float amount = hsl[1] * std::min(hsl[2], 1.0f - hsl[2]);
+		const float h = hsl[0] * 12.0f;
+		const float r = h, g = h + 8.0f, b = h + 4.0f;
+		const float k[3] = { r - 12.0f * std::floor(r / 12.0f), g - 12.0f * std::floor(g / 12.0f), b - 12.0f * std::floor(b / 12.0f) };
+
+		for (int i = 0; i < 3; ++i)
+			rgb[i] = hsl[2] - amount * std::max(-1.0f, std::min(std::min(k[i] - 3.0f, 9.0f - k[i]), 1.0f));
+	}
+
+	static void rgbToYCbCr(const float* rgb, float* ycbcr)
+	{
+		ycbcr[0] = 0.299f * rgb[0] + 0.587f * rgb[1] + 0.114f * rgb[2];
+		ycbcr[1] = 0.5f - 0.168736f * rgb[0] - 0.331264f * rgb[1] + 0.5f * rgb[2];
+		ycbcr[2] = 0.5f + 0.5f * rgb[0] - 0.418688f * rgb[1] - 0.081312f * rgb[2];
+	}
+
+	static void yCbCrToRgb(const float* ycbcr, float* rgb)
+	{
+		const float cb = ycbcr[1] - 0.5f;
+		const float cr = ycbcr[2] - 0.5f;
+		rgb[0] = ycbcr[0] + 1.402f * cr;
+		rgb[1] = ycbcr[0] - 0.344136f * cb - 0.714136f * cr;
+		rgb[2] = ycbcr[0] + 1.772f * cb;
+	}
+
+#ifdef LITCOLOR_SSE2
+	//four interleaved triples to one register per channel and back
+	static void loadTriples(const float* src, __m128& x, __m128& y, __m128& z)
+	{
+		x = _mm_setr_ps(src[0], src[3], src[6], src[9]);
+		y = _mm_setr_ps(src[1], src[4], src[7], src[10]);
+		z = _mm_setr_ps(src[2], src[5], src[8], src[11]);
+	}
+
+	static void storeTriples(float* dst, const __m128 x, const __m128 y, const __m128 z)
+	{
+		float channels[3][4];
+		_mm_storeu_ps(channels[0], x);
+		_mm_storeu_ps(channels[1], y);
+		_mm_storeu_ps(channels[2], z);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			dst[i * 3] = channels[0][i];
+			dst[i * 3 + 1] = channels[1][i];
+			dst[i * 3 + 2] = channels[2][i];
+		}
+	}
+
+	static __m128 select(const __m128 mask, const __m128 a, const __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	//same rounding as FloatToChannel(), max first so NaN turns into 0
+	static __m128i toChannel4(const __m128 x)
+	{
+		const __m128 val = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(val, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+	}
+
+	static __m128 floor4(const __m128 x)
+	{
+		const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+		return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.0f)));
+	}
+
+	static __m128 hue4(const __m128 r, const __m128 g, const __m128 b, const __m128 max, const __m128 delta)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 chromatic = _mm_cmpgt_ps(delta, zero);
+		const __m128 divisor = select(chromatic, delta, one);
+		const __m128 red = _mm_div_ps(_mm_sub_ps(g, b), divisor);
+		const __m128 green = _mm_add_ps(_mm_set1_ps(2.0f), _mm_div_ps(_mm_sub_ps(b, r), divisor));
+		const __m128 blue = _mm_add_ps(_mm_set1_ps(4.0f), _mm_div_ps(_mm_sub_ps(r, g), divisor));
+		__m128 h = select(_mm_cmpeq_ps(max, r), red, select(_mm_cmpeq_ps(max, g), green, blue));
+		h = _mm_div_ps(h, _mm_set1_ps(6.0f));
+		h = _mm_add_ps(h, _mm_and_ps(_mm_cmplt_ps(h, zero), one));
+		return _mm_and_ps(h, chromatic);
+	}
+#endif
+
+public:
+	//converts count channels, e.g. 4 * pixels for RGBA. Rounds to nearest, clamps to 0 - 255, NaN becomes 0
+	static void FloatToBytes(const float* src, uint8_t* dst, const size_t count)
+	{
+		size_t i = 0;
+
+#ifdef LITCOLOR_SSE2
+		const __m128 scale = _mm_set1_ps(255.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i words[4];
+
+			for (int j = 0; j < 4; ++j)
+			{
+				//max first so NaN turns into 0 like in FloatToChannel()
+				__m128 val = _mm_max_ps(_mm_loadu_ps(src + i + j * 4), zero);
+				val = _mm_min_ps(val, one);
+				words[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(val, scale), half));
+			}
+
+			const __m128i low = _mm_packs_epi32(words[0], words[1]);
+			const __m128i high = _mm_packs_epi32(words[2], words[3]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(low, high));
+		}
+#endif
+
+		for (; i < count; ++i)
+			dst[i] = static_cast<uint8_t>(LitColor::FloatToChannel(src[i]));
+	}
+
+	//same as LitColor, value / 255
+	static void BytesToFloat(const uint8_t* src, float* dst, const size_t count)
+	{
+		size_t i = 0;
+
+#ifdef LITCOLOR_SSE2
+		const __m128 divisor = _mm_set1_ps(255.0f);
+		const __m128i zero = _mm_setzero_si128();
+
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+			const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+			_mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), divisor));
+			_mm_storeu_ps(dst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), divisor));
+			_mm_storeu_ps(dst + i + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), divisor));
+			_mm_storeu_ps(dst + i + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), divisor));
+		}
+#endif
+
+		for (; i < count; ++i)
+			dst[i] = static_cast<float>(src[i]) / 255.0f;
+	}
+
+	//IEEE 754 half precision without F16C, results are identical to LitColor::HalfToFloat()
+	static void HalfToFloat(const uint16_t* src, float* dst, const size_t count)
+	{
+		size_t i = 0;
+
+#ifdef LITCOLOR_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i exponentMask = _mm_set1_epi32(0x0F800000);
+		const __m128i rebias = _mm_set1_epi32(0x38000000);
+		const __m128i subnormalBias = _mm_set1_epi32(0x00800000);
+		const __m128 subnormalOffset = _mm_set1_ps(6.103515625e-05f);
+
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+			for (int j = 0; j < 2; ++j)
+			{
+				const __m128i half = j == 0 ? _mm_unpacklo_epi16(halves, zero) : _mm_unpackhi_epi16(halves, zero);
+				const __m128i sign = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x8000)), 16);
+				__m128i bits = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x7FFF)), 13);
+				const __m128i exponent = _mm_and_si128(bits, exponentMask);
+				bits = _mm_add_epi32(bits, rebias);
+				bits = _mm_add_epi32(bits, _mm_and_si128(_mm_cmpeq_epi32(exponent, exponentMask), rebias));
+				const __m128i isSubnormal = _mm_cmpeq_epi32(exponent, zero);
+				const __m128i subnormal = _mm_castps_si128(_mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, subnormalBias)), subnormalOffset));
+				bits = _mm_or_si128(_mm_andnot_si128(isSubnormal, bits), _mm_and_si128(isSubnormal, subnormal));
+				_mm_storeu_ps(dst + i + j * 4, _mm_castsi128_ps(_mm_or_si128(bits, sign)));
+			}
+		}
+#endif
+
+		for (; i < count; ++i)
+			dst[i] = LitColor::HalfToFloat(src[i]);
+	}
+
+	//rounds to nearest even, results are identical to LitColor::FloatToHalf()
+	static void FloatToHalf(const float* src, uint16_t* dst, const size_t count)
+	{
+		size_t i = 0;
+
+#ifdef LITCOLOR_SSE2
+		const __m128i signMask = _mm_set1_epi32(static_cast<int>(0x80000000));
+		const __m128i overflow = _mm_set1_epi32(0x47800000);
+		const __m128i minNormal = _mm_set1_epi32(0x38800000);
+		const __m128i subnormalMagic = _mm_set1_epi32(0x3F000000);
+		const __m128i normalBias = _mm_set1_epi32(static_cast<int>(0xC8000FFF));
+		const __m128i one = _mm_set1_epi32(1);
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i words[2];
+
+			for (int j = 0; j < 2; ++j)
+			{
+				const __m128i bits = _mm_castps_si128(_mm_loadu_ps(src + i + j * 4));
+				const __m128i sign = _mm_and_si128(bits, signMask);
+				const __m128i abs = _mm_xor_si128(bits, sign);
+				const __m128i isRegular = _mm_cmpgt_epi32(overflow, abs);
+				const __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, abs);
+				const __m128i isNan = _mm_cmpgt_epi32(abs, _mm_set1_epi32(0x7F800000));
+				const __m128i infOrNan = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(isNan, _mm_set1_epi32(0x0200)));
+				const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(abs), _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+				const __m128i odd = _mm_and_si128(_mm_srli_epi32(abs, 13), one);
+				const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(abs, normalBias), odd), 13);
+				const __m128i finite = _mm_or_si128(_mm_andnot_si128(isSubnormal, normal), _mm_and_si128(isSubnormal, subnormal));
+				__m128i half = _mm_or_si128(_mm_andnot_si128(isRegular, infOrNan), _mm_and_si128(isRegular, finite));
+				half = _mm_or_si128(half, _mm_srli_epi32(sign, 16));
+				//sign extend so the signed saturating pack keeps all 16 bits
+				words[j] = _mm_srai_epi32(_mm_slli_epi32(half, 16), 16);
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(words[0], words[1]));
+		}
+#endif
+
+		for (; i < count; ++i)
+			dst[i] = LitColor::FloatToHalf(src[i]);
+	}
+
+	//RGBA16F pixels to RGBA8888 bytes in memory order
+	static void RGBA16FToRGBA8888(const uint16_t* src, uint8_t* dst, const size_t pixelCount)
+	{
+		float floats[256];
+
+		for (size_t i = 0; i < pixelCount * 4; i += 256)
+		{
+			const size_t count = std::min<size_t>(256, pixelCount * 4 - i);
+			HalfToFloat(src + i, floats, count);
+			FloatToBytes(floats, dst + i, count);
+		}
+	}
+
+	static void RGBA8888ToRGBA16F(const uint8_t* src, uint16_t* dst, const size_t pixelCount)
+	{
+		float floats[256];
+
+		for (size_t i = 0; i < pixelCount * 4; i += 256)
+		{
+			const size_t count = std::min<size_t>(256, pixelCount * 4 - i);
+			BytesToFloat(src + i, floats, count);
+			FloatToHalf(floats, dst + i, count);
+		}
+	}
+
+	//linear float RGBA to sRGB encoded bytes, alpha stays linear
+	static void LinearFloatToSrgbBytes(const float* src, uint8_t* dst, const size_t pixelCount)
+	{
+		for (size_t i = 0; i < pixelCount * 4; i += 4)
+		{
+			dst[i] = encodeSrgb(src[i]);
+			dst[i + 1] = encodeSrgb(src[i + 1]);
+			dst[i + 2] = encodeSrgb(src[i + 2]);
+			dst[i + 3] = static_cast<uint8_t>(LitColor::FloatToChannel(src[i + 3]));
+		}
+	}
+
+	//sRGB encoded bytes to linear float RGBA, alpha stays linear
+	static void SrgbBytesToLinearFloat(const uint8_t* src, float* dst, const size_t pixelCount)
+	{
+		const float* table = srgbDecodeTable();
+
+		for (size_t i = 0; i < pixelCount * 4; i += 4)
+		{
+			dst[i] = table[src[i]];
+			dst[i + 1] = table[src[i + 1]];
+			dst[i + 2] = table[src[i + 2]];
+			dst[i + 3] = static_cast<float>(src[i + 3]) / 255.0f;
+		}
+	}
+
+	//RGBF pixels to RGBA8888 bytes with a fixed alpha
+	static void RGBFToRGBA8888(const float* src, uint8_t* dst, const size_t pixelCount, const uint8_t alpha = 0xFF)
+	{
+		size_t i = 0;
+
+#ifdef LITCOLOR_SSE2
+		const __m128i alphaBits = _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(alpha) << 24));
+
+		for (; i + 4 <= pixelCount; i += 4)
+		{
+			//r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3 to one register per channel
+			const __m128 a = _mm_loadu_ps(src + i * 3);
+			const __m128 b = _mm_loadu_ps(src + i * 3 + 4);
+			const __m128 c = _mm_loadu_ps(src + i * 3 + 8);
+			const __m128 red = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(3, 1, 3, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+			const __m128 green = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+			const __m128 blue = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+			//x86 is little endian, so R ends up in the first byte of each pixel
+			__m128i pixels = _mm_or_si128(toChannel4(red), _mm_slli_epi32(toChannel4(green), 8));
+			pixels = _mm_or_si128(pixels, _mm_or_si128(_mm_slli_epi32(toChannel4(blue), 16), alphaBits));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), pixels);
+		}
+#endif
+
+		for (; i < pixelCount; ++i)
+		{
+			FloatToBytes(src + i * 3, dst + i * 4, 3);
+			dst[i * 4 + 3] = alpha;
+		}
+	}
+
+	//RGBA8888 words as returned by LitColor::GetRGBA()
+	static void RGBAFToRGBA8888(const float* src, uint32_t* dst, const size_t pixelCount)
+	{
+		FloatToBytes(src, reinterpret_cast<uint8_t*>(dst), pixelCount * 4);
+
+		for (size_t i = 0; i < pixelCount; ++i)
+		{
+			uint8_t bytes[4];
+			std::memcpy(bytes, dst + i, 4);
+			dst[i] = static_cast<uint32_t>(bytes[0]) << 24 | static_cast<uint32_t>(bytes[1]) << 16 | static_cast<uint32_t>(bytes[2]) << 8 | bytes[3];
+		}
+	}
+
+	static void RGBA8888ToRGBAF(const uint32_t* src, float* dst, const size_t pixelCount)
+	{
+		for (size_t i = 0; i < pixelCount; ++i)
+		{
+			dst[i * 4] = static_cast<float>(src[i] >> 24) / 255.0f;
+			dst[i * 4 + 1] = static_cast<float>((src[i] >> 16) & 0xFF) / 255.0f;
+			dst[i * 4 + 2] = static_cast<float>((src[i] >> 8) & 0xFF) / 255.0f;
+			dst[i * 4 + 3] = static_cast<float>(src[i] & 0xFF) / 255.0f;
+		}
+	}
+
+	//color space conversions over interleaved float triples, src and dst may be the same. All channels are 0.0 - 1.0, hue is a fraction of a full turn
+	static void RGBToHSV(const float* src, float* dst, const size_t pixelCount)
+	{
+		size_t i = 0;
+
+#ifdef LITCOLOR_SSE2
+		for (; i + 4 <= pixelCount; i += 4)
+		{
+			__m128 r, g, b;
+			loadTriples(src + i * 3, r, g, b);
+			const __m128 max = _mm_max_ps(r, _mm_max_ps(g, b));
+			const __m128 delta = _mm_sub_ps(max, _mm_min_ps(r, _mm_min_ps(g, b)));
+			const __m128 positive = _mm_cmpgt_ps(max, _mm_setzero_ps());
+			const __m128 saturation = _mm_and_ps(_mm_div_ps(delta, select(positive, max, _mm_set1_ps(1.0f))), positive);
+			storeTriples(dst + i * 3, hue4(r, g, b, max, delta), saturation, max);
+		}
+#endif
+
+		for (; i < pixelCount; ++i)
+			rgbToHsv(src + i * 3, dst + i * 3);
+	}
+
+	static void HSVToRGB(const float* src, float* dst, const size_t pixelCount)
+	{
+		size_t i = 0;
+
+#ifdef LITCOLOR_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 four = _mm_set1_ps(4.0f);
+		const __m128 six = _mm_set1_ps(6.0f);
+
+		for (; i + 4 <= pixelCount; i += 4)
+		{
+			__m128 h, s, v;
+			loadTriples(src + i * 3, h, s, v);
+			const __m128 chroma = _mm_mul_ps(v, s);
+			h = _mm_mul_ps(h, six);
+			__m128 rgb[3];
+
+			for (int j = 0; j < 3; ++j)
+			{
+				const __m128 n = _mm_add_ps(h, _mm_set1_ps(5.0f - 2.0f * static_cast<float>(j)));
+				const __m128 k = _mm_sub_ps(n, _mm_mul_ps(six, floor4(_mm_div_ps(n, six))));
+				const __m128 amount = _mm_max_ps(zero, _mm_min_ps(_mm_min_ps(k, _mm_sub_ps(four, k)), one));
+				rgb[j] = _mm_sub_ps(v, _mm_mul_ps(chroma, amount));
+			}
+
+			storeTriples(dst + i * 3, rgb[0], rgb[1], rgb[2]);
+		}
+#endif
+
+		for (; i < pixelCount; ++i)
+		{
+			const float hsv[3] = { src[i * 3], src[i * 3 + 1], src[i * 3 + 2] };
+			hsvToRgb(hsv, dst + i * 3);
+		}
+	}
+
+	static void RGBToHSL(const float* src, float* dst, const size_t pixelCount)
+	{
+		size_t i = 0;
+
+#ifdef LITCOLOR_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+		for (; i + 4 <= pixelCount; i += 4)
+		{
+			__m128 r, g, b;
+			loadTriples(src + i * 3, r, g, b);
+			const __m128 max = _mm_max_ps(r, _mm_max_ps(g, b));
+			const __m128 min = _mm_min_ps(r, _mm_min_ps(g, b));
+			const __m128 delta = _mm_sub_ps(max, min);
+			const __m128 sum = _mm_add_ps(max, min);
+			const __m128 divisor = _mm_sub_ps(one, _mm_and_ps(_mm_sub_ps(sum, one), absMask));
+			const __m128 valid = _mm_and_ps(_mm_cmpgt_ps(delta, zero), _mm_cmpgt_ps(divisor, zero));
+			const __m128 saturation = _mm_and_ps(_mm_div_ps(delta, select(valid, divisor, one)), valid);
+			storeTriples(dst + i * 3, hue4(r, g, b, max, delta), saturation, _mm_mul_ps(sum, _mm_set1_ps(0.5f)));
+		}
+#endif
+
+		for (; i < pixelCount; ++i)
+			rgbToHsl(src + i * 3, dst + i * 3);
+	}
+
+	static void HSLToRGB(const float* src, float* dst, const size_t pixelCount)
+	{
+		size_t i = 0;
+
+#ifdef LITCOLOR_SSE2
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 twelve = _mm_set1_ps(12.0f);
+
+		for (; i + 4 <= pixelCount; i += 4)
+		{
+			__m128 h, s, l;
+			loadTriples(src + i * 3, h, s, l);
+			const __m128 amount = _mm_mul_ps(s, _mm_min_ps(l, _mm_sub_ps(one, l)));
+			h = _mm_mul_ps(h, twelve);
+			__m128 rgb[3];
+
+			for (int j = 0; j < 3; ++j)
+			{
+				const __m128 n = _mm_add_ps(h, _mm_set1_ps(j == 0 ? 0.0f : (j == 1 ? 8.0f : 4.0f)));
+				const __m128 k = _mm_sub_ps(n, _mm_mul_ps(twelve, floor4(_mm_div_ps(n, twelve))));
+				const __m128 offset = _mm_min_ps(_mm_min_ps(_mm_sub_ps(k, _mm_set1_ps(3.0f)), _mm_sub_ps(_mm_set1_ps(9.0f), k)), one);
+				rgb[j] = _mm_sub_ps(l, _mm_mul_ps(amount, _mm_max_ps(_mm_set1_ps(-1.0f), offset)));
+			}
+
+			storeTriples(dst + i * 3, rgb[0], rgb[1], rgb[2]);
+		}
+#endif
+
+		for (; i < pixelCount; ++i)
+		{
+			const float hsl[3] = { src[i * 3], src[i * 3 + 1], src[i * 3 + 2] };
+			hslToRgb(hsl, dst + i * 3);
+		}
+	}
+
+	//BT.601 full range as used by JPEG, chroma is centered at 0.5
+	static void RGBToYCbCr(const float* src, float* dst, const size_t pixelCount)
+	{
+		size_t i = 0;
+
+#ifdef LITCOLOR_SSE2
+		const __m128 half = _mm_set1_ps(0.5f);
+
+		for (; i + 4 <= pixelCount; i += 4)
+		{
+			__m128 r, g, b;
+			loadTriples(src + i * 3, r, g, b);
+			const __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(0.299f)), _mm_mul_ps(g, _mm_set1_ps(0.587f))), _mm_mul_ps(b, _mm_set1_ps(0.114f)));
+			const __m128 cb = _mm_add_ps(_mm_sub_ps(_mm_sub_ps(half, _mm_mul_ps(r, _mm_set1_ps(0.168736f))), _mm_mul_ps(g, _mm_set1_ps(0.331264f))), _mm_mul_ps(b, half));
+			const __m128 cr = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(half, _mm_mul_ps(r, half)), _mm_mul_ps(g, _mm_set1_ps(0.418688f))), _mm_mul_ps(b, _mm_set1_ps(0.081312f)));
+			storeTriples(dst + i * 3, y, cb, cr);
+		}
+#endif
+
+		for (; i < pixelCount; ++i)
+		{
+			const float rgb[3] = { src[i * 3], src[i * 3 + 1], src[i * 3 + 2] };
+			rgbToYCbCr(rgb, dst + i * 3);
+		}
+	}
+
+	static void YCbCrToRGB(const float* src, float* dst, const size_t pixelCount)
+	{
+		size_t i = 0;
+
+#ifdef LITCOLOR_SSE2
+		const __m128 half = _mm_set1_ps(0.5f);
+
+		for (; i + 4 <= pixelCount; i += 4)
+		{
+			__m128 y, cb, cr;
+			loadTriples(src + i * 3, y, cb, cr);
+			cb = _mm_sub_ps(cb, half);
+			cr = _mm_sub_ps(cr, half);
+			const __m128 r = _mm_add_ps(y, _mm_mul_ps(cr, _mm_set1_ps(1.402f)));
+			const __m128 g = _mm_sub_ps(_mm_sub_ps(y, _mm_mul_ps(cb, _mm_set1_ps(0.344136f))), _mm_mul_ps(cr, _mm_set1_ps(0.714136f)));
+			const __m128 b = _mm_add_ps(y, _mm_mul_ps(cb, _mm_set1_ps(1.772f)));
+			storeTriples(dst + i * 3, r, g, b);
+		}
+#endif
+
+		for (; i < pixelCount; ++i)
+		{
+			const float ycbcr[3] = { src[i * 3], src[i * 3 + 1], src[i * 3 + 2] };
+			yCbCrToRgb(ycbcr, dst + i * 3);
+		}
+	}
+};
@@ -0,0 +1,477 @@
+﻿#pragma once
+
+#include "LitColorScanner.h"
+
+//counts the colors of a memory region interpreted as an array of one type, e.g. a texture or framebuffer
+class LitColorHistogram
+{
+public:
+	struct Entry
+	{
+		LitColor Color;
+		uint64_t Count = 0;
+	};
+
+private:
+	struct Bin
+	{
+		uint32_t Rgba;
+		uint64_t Count;
+	};
+
+	//open addressing, a count of 0 marks an empty slot
+	struct Table
+	{
+		std::vector<uint32_t> Keys;
+		std::vector<uint64_t> Counts;
+		size_t Used = 0;
+
+		static size_t hash(const uint32_t key)
+		{
+			return static_cast<size_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull) >> 32);
+		}
+
+		void insert(const uint32_t key, const uint64_t count)
+		{
+			const size_t mask = Keys.size() - 1;
+			size_t slot = hash(key) & mask;
+
+			while (Counts[slot] && Keys[slot] != key)
+				slot = (slot + 1) & mask;
+
+			if (!Counts[slot])
+			{
+				Keys[slot] = key;
+				++Used;
+			}
+
+			Counts[slot] += count;
+		}
+
+		void Add(const uint32_t key, const uint64_t count)
+		{
+			if ((Used + 1) * 2 > Keys.size())
+			{
+				std::vector<uint32_t> keys(std::max<size_t>(Keys.size() * 2, 0x1000));
+				std::vector<uint64_t> counts(keys.size());
+				keys.swap(Keys);
+				counts.swap(Counts);
+				Used = 0;
+
+				for (size_t i = 0; i < keys.size(); ++i)
+					if (counts[i])
+						insert(keys[i], counts[i]);
+			}
+
+			insert(key, count);
+		}
+	};
+
+	static constexpr size_t DENSE_BINS = 0x10000;
+
+	int _type = LitColor::RGBA8888;
+	bool _bigEndian = true;
+	size_t _stride = 4;
+	unsigned int _threadCount = 0;
+	std::vector<Bin> _bins;
+	uint64_t _total = 0;
+	uint64_t _invalid = 0;
+
+	bool usesAlpha() const
+	{
+		return _type == LitColor::RGBA8888 || _type == LitColor::RGBAF || _type == LitColor::RGB5A3 || _type == LitColor::RGBA16F;
+	}
+
+	static uint32_t expand16(const int type, const uint16_t code)
+	{
+		if (type == LitColor::RGB565)
+			return LitColor::RGB565ToRGB888(code);
+
+		return (code & 0x8000) ? (LitColor::RGB5A3ToRGB888(code) | 0xFF) : LitColor::RGB5A3ToRGBA8888(code);
+	}
+
+	//16 bit codes are counted in a dense table per thread
+	template<int Type> void countDense(const uint8_t* data, const size_t first, const size_t last, std::vector<uint64_t>& bins, uint64_t&) const
+	{
+		const LitColorQuery loader(LitColor(), Type, LitColorQuery::EXACT, _bigEndian);
+		uint32_t word;
+
+		for (size_t i = first; i < last; ++i)
+		{
+			loader.LoadWord<Type>(data + i * _stride, word);
+			++bins[word];
+		}
+	}
+
+	//everything else is converted to RGBA8888 and counted in a hash table per thread. Runs of the same color are added at once
+	template<int Type> void countSparse(const uint8_t* data, const size_t first, const size_t last, Table& table, uint64_t& invalid) const
+	{
+		const LitColorQuery loader(LitColor(), Type, LitColorQuery::EXACT, _bigEndian);
+		uint32_t previous = 0;
+		uint64_t run = 0;
+		uint32_t word;
+
+		for (size_t i = first; i < last; ++i)
+		{
+			if (!loader.LoadWord<Type>(data + i * _stride, word))
+			{
+				++invalid;
+				continue;
+			}
+
+			if (run && word == previous)
+			{
+				++run;
+				continue;
+			}
+
+			if (run)
+				table.Add(previous, run);
+
+			previous = word;
+			run = 1;
+		}
+
+		if (run)
+			table.Add(previous, run);
+	}
+
+	void countRange(const uint8_t* data, const size_t first, const size_t last, std::vector<uint64_t>& dense, Table& sparse, uint64_t& invalid) const
+	{
+		switch (_type)
+		{
+		case LitColor::RGB888: countSparse<LitColor::RGB888>(data, first, last, sparse, invalid); break;
+		case LitColor::RGBA8888: countSparse<LitColor::RGBA8888>(data, first, last, sparse, invalid); break;
+		case LitColor::RGBF: countSparse<LitColor::RGBF>(data, first, last, sparse, invalid); break;
+		case LitColor::RGBAF: countSparse<LitColor::RGBAF>(data, first, last, sparse, invalid); break;
+		case LitColor::RGBA16F: countSparse<LitColor::RGBA16F>(data, first, last, sparse, invalid); break;
+		case LitColor::RGB5A3: countDense<LitColor::RGB5A3>(data, first, last, dense, invalid); break;
+		default: countDense<LitColor::RGB565>(data, first, last, dense, invalid);
+		}
+	}
+
+	int channelCount() const
+	{
+		return usesAlpha() ? 4 : 3;
+	}
+
+	static int channel(const uint32_t rgba, const int index)
+	{
+		return static_cast<int>((rgba >> (24 - index * 8)) & 0xFF);
+	}
+
+	std::vector<Entry> toEntries(const std::vector<Bin>& bins) const
+	{
+		std::vector<Entry> entries(bins.size());
+
+		for (size_t i = 0; i < bins.size(); ++i)
+			entries[i] = { LitColor(bins[i].Rgba, usesAlpha()), bins[i].Count };
+
+		return entries;
+	}
+
+	//splits the box with the most pixels times its widest channel range at the weighted median of that channel
+	std::vector<Bin> medianCut(std::vector<Bin> bins, const size_t colorCount) const
+	{
+		struct Box
+		{
+			size_t Begin;
+			size_t End;
+			uint64_t Count;
+			int Channel;
+			int Range;
+		};
+
+		const int channels = channelCount();
+
+		auto makeBox = [&](const size_t begin, const size_t end)
+		{
+			Box box = { begin, end, 0, 0, -1 };
+			int min[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+			int max[4] = { 0, 0, 0, 0 };
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				box.Count += bins[i].Count;
+
+				for (int c = 0; c < channels; ++c)
+				{
+					min[c] = std::min(min[c], channel(bins[i].Rgba, c));
+					max[c] = std::max(max[c], channel(bins[i].Rgba, c));
+				}
+			}
+
+			for (int c = 0; c < channels; ++c)
+			{
+				if (max[c] - min[c] > box.Range)
+				{
+					box.Range = max[c] - min[c];
+					box.Channel = c;
+				}
+			}
+
+			return box;
+		};
+
+		std::vector<Box> boxes = { makeBox(0, bins.size()) };
+
+		while (boxes.size() < colorCount)
+		{
+			size_t widest = boxes.size();
+			double widestScore = 0.0;
+
+			for (size_t i = 0; i < boxes.size(); ++i)
+			{
+				const double score = static_cast<double>(boxes[i].Count) * boxes[i].Range;
+
+				if (boxes[i].End - boxes[i].Begin > 1 && score > widestScore)
+				{
+					widest = i;
+					widestScore = score;
+				}
+			}
+
+			if (widest == boxes.size())
+				break;
+
+			const Box box = boxes[widest];
+			std::sort(bins.begin() + box.Begin, bins.begin() + box.End, [&](const Bin& a, const Bin& b) { return channel(a.Rgba, box.Channel) < channel(b.Rgba, box.Channel); });
+			size_t split = box.Begin;
+
+			for (uint64_t count = 0; split < box.End - 1 && count + bins[split].Count <= box.Count / 2; ++split)
+				count += bins[split].Count;
+
+			split = std::max(split, box.Begin + 1);
+			boxes[widest] = makeBox(box.Begin, split);
+			boxes.push_back(makeBox(split, box.End));
+		}
+
+		std::vector<Bin> palette;
+
+		for (const auto& box : boxes)
+		{
+			double sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+
+			for (size_t i = box.Begin; i < box.End; ++i)
+				for (int c = 0; c < 4; ++c)
+					sums[c] += static_cast<double>(channel(bins[i].Rgba, c)) * static_cast<double>(bins[i].Count);
+
+			uint32_t rgba = 0;
+
+			for (int c = 0; c < 4; ++c)
+				rgba |= static_cast<uint32_t>(sums[c] / static_cast<double>(box.Count) + 0.5) << (24 - c * 8);
+
+			palette.push_back({ rgba, box.Count });
+		}
+
+		return palette;
+	}
+
+	//weighted k-means over the distinct colors, the assignment step runs in parallel
+	void refine(std::vector<Bin>& palette, const int iterations) const
+	{
+		const int channels = channelCount();
+		const size_t k = palette.size();
+		std::vector<std::vector<double>> sums(_threadCount, std::vector<double>(k * 5));
+
+		for (int iteration = 0; iteration < iterations; ++iteration)
+		{
+			const size_t share = (_bins.size() + _threadCount - 1) / _threadCount;
+			std::vector<std::thread> workers;
+
+			for (unsigned int t = 0; t < _threadCount; ++t)
+			{
+				workers.emplace_back([&, t]()
+				{
+					std::vector<double>& sum = sums[t];
+					std::fill(sum.begin(), sum.end(), 0.0);
+
+					for (size_t i = t * share; i < std::min(_bins.size(), (t + 1) * share); ++i)
+					{
+						size_t nearest = 0;
+						int nearestDistance = 0x7FFFFFFF;
+
+						for (size_t p = 0; p < k; ++p)
+						{
+							int distance = 0;
+
+							for (int c = 0; c < channels; ++c)
+							{
+								const int delta = channel(_bins[i].Rgba, c) - channel(palette[p].Rgba, c);
+								distance += delta * delta;
+							}
+
+							if (distance < nearestDistance)
+							{
+								nearest = p;
+								nearestDistance = distance;
+							}
+						}
+
+						const double weight = static_cast<double>(_bins[i].Count);
+
+						for (int c = 0; c < 4; ++c)
+							sum[nearest * 5 + c] += channel(_bins[i].Rgba, c) * weight;
+
+						sum[nearest * 5 + 4] += weight;
+					}
+				});
+			}
+
+			for (auto& thread : workers)
+				thread.join();
+
+			for (size_t p = 0; p < k; ++p)
+			{
+				double total[5] = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+				for (const auto& sum : sums)
+					for (int c = 0; c < 5; ++c)
+						total[c] += sum[p * 5 + c];
+
+				palette[p].Count = static_cast<uint64_t>(total[4]);
+
+				if (total[4] == 0.0)
+					continue;
+
+				uint32_t rgba = 0;
+
+				for (int c = 0; c < 4; ++c)
+					rgba |= static_cast<uint32_t>(total[c] / total[4] + 0.5) << (24 - c * 8);
+
+				palette[p].Rgba = rgba;
+			}
+		}
+	}
+
+public:
+	//stride defaults to the size of type, larger strides read one color per record
+	LitColorHistogram(const int type, const bool bigEndian = true, const size_t stride = 0, const unsigned int threadCount = 0)
+		: _type(type), _bigEndian(bigEndian), _stride(std::max(stride, LitColorScanner::GetTypeSize(type))), _threadCount(threadCount)
+	{
+		if (_threadCount == 0)
+			_threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	//replaces the current counts. Float colors out of 0.0 - 1.0 are counted as invalid
+	void Build(const uint8_t* data, const size_t size)
+	{
+		const size_t typeSize = LitColorScanner::GetTypeSize(_type);
+		const size_t count = size >= typeSize ? (size - typeSize) / _stride + 1 : 0;
+		const bool dense = _type == LitColor::RGB565 || _type == LitColor::RGB5A3;
+		const size_t share = (count + _threadCount - 1) / _threadCount;
+		std::vector<std::vector<uint64_t>> denseBins(dense ? _threadCount : 0, std::vector<uint64_t>(DENSE_BINS));
+		std::vector<Table> tables(_threadCount);
+		std::vector<uint64_t> invalid(_threadCount);
+		std::vector<std::thread> workers;
+		std::vector<uint64_t> empty;
+
+		for (unsigned int t = 0; t < _threadCount && t * share < count; ++t)
+			workers.emplace_back([&, t]() { countRange(data, t * share, std::min(count, (t + 1) * share), dense ? denseBins[t] : empty, tables[t], invalid[t]); });
+
+		for (auto& thread : workers)
+			thread.join();
+
+		_bins.clear();
+		_total = count;
+		_invalid = 0;
+
+		for (const uint64_t val : invalid)
+			_invalid += val;
+
+		if (dense)
+		{
+			//different codes may expand to the same color, they are combined below
+			for (size_t code = 0; code < DENSE_BINS; ++code)
+			{
+				uint64_t sum = 0;
+
+				for (const auto& bins : denseBins)
+					sum += bins[code];
+
+				if (sum)
+					_bins.push_back({ expand16(_type, static_cast<uint16_t>(code)), sum });
+			}
+
+			std::sort(_bins.begin(), _bins.end(), [](const Bin& a, const Bin& b) { return a.Rgba < b.Rgba; });
+			size_t out = 0;
+
+			for (size_t i = 0; i < _bins.size(); ++i)
+			{
+				if (out && _bins[out - 1].Rgba == _bins[i].Rgba)
+					_bins[out - 1].Count += _bins[i].Count;
+				else
+					_bins[out++] = _bins[i];
+			}
+
+			_bins.resize(out);
+		}
+		else
+		{
+			Table& merged = tables.front();
+
+			for (size_t t = 1; t < tables.size(); ++t)
+				for (size_t i = 0; i < tables[t].Keys.size(); ++i)
+					if (tables[t].Counts[i])
+						merged.Add(tables[t].Keys[i], tables[t].Counts[i]);
+
+			_bins.reserve(merged.Used);
+
+			for (size_t i = 0; i < merged.Keys.size(); ++i)
+				if (merged.Counts[i])
+					_bins.push_back({ merged.Keys[i], merged.Counts[i] });
+		}
+
+		std::sort(_bins.begin(), _bins.end(), [](const Bin& a, const Bin& b) { return a.Count > b.Count || (a.Count == b.Count && a.Rgba < b.Rgba); });
+	}
+
+	//number of values read, including invalid ones
+	uint64_t GetTotal() const
+	{
+		return _total;
+	}
+
+	uint64_t GetInvalidCount() const
+	{
+		return _invalid;
+	}
+
+	size_t GetUniqueCount() const
+	{
+		return _bins.size();
+	}
+
+	uint64_t GetCount(const LitColor& color) const
+	{
+		for (const auto& bin : _bins)
+			if (bin.Rgba == color.GetRGBA())
+				return bin.Count;
+
+		return 0;
+	}
+
+	//the most frequent colors first
+	std::vector<Entry> GetTop(const size_t count) const
+	{
+		return toEntries(std::vector<Bin>(_bins.begin(), _bins.begin() + std::min(count, _bins.size())));
+	}
+
+	//colorCount representative colors by median cut, refined by weighted k-means. Counts are the pixels closest to each color
+	std::vector<Entry> ExtractPalette(const size_t colorCount, const int refineIterations = 4) const
+	{
+		if (_bins.empty() || colorCount == 0)
+			return {};
+
+		if (_bins.size() <= colorCount)
+			return GetTop(colorCount);
+
+		std::vector<Bin> palette = medianCut(_bins, colorCount);
+		refine(palette, refineIterations);
+		std::sort(palette.begin(), palette.end(), [](const Bin& a, const Bin& b) { return a.Count > b.Count; });
+
+		while (!palette.empty() && palette.back().Count == 0)
+			palette.pop_back();
+
+		return toEntries(palette);
+	}
+};
@@ -0,0 +1,265 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <thread>
+#include <vector>
+#include "LitColor.h"
+
+class LitColorIndex
+{
+public:
+	enum Spaces
+	{
+		SPACE_RGB,
+		SPACE_RGBA,
+		SPACE_LAB
+	};
+
+	struct Result
+	{
+		size_t Index = 0;
+		uint32_t Rgba = 0;
+		float Distance = 0.0f;
+
+		bool operator<(const Result& other) const
+		{
+			return Distance < other.Distance;
+		}
+	};
+
+private:
+	struct Point
+	{
+		float Coords[4];
+		uint32_t Rgba;
+		size_t Index;
+	};
+
+	static constexpr size_t PARALLEL_THRESHOLD = 0x10000;
+
+	std::vector<Point> _points;
+	int _space = SPACE_RGB;
+	int _dimensions = 3;
+
+	static float linearize(const float channel)
+	{
+		return channel <= 0.04045f ? channel / 12.92f : std::pow((channel + 0.055f) / 1.055f, 2.4f);
+	}
+
+	static float labCurve(const float t)
+	{
+		return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+	}
+
+	void toCoords(const uint32_t rgba, float* coords) const
+	{
+		if (_space == SPACE_LAB)
+		{
+			ToLab(rgba, coords);
+			return;
+		}
+
+		coords[0] = static_cast<float>(rgba >> 24);
+		coords[1] = static_cast<float>((rgba >> 16) & 0xFF);
+		coords[2] = static_cast<float>((rgba >> 8) & 0xFF);
+		coords[3] = static_cast<float>(rgba & 0xFF);
+	}
+
+	float squaredDistance(const float* a, const float* b) const
+	{
+		float sum = 0.0f;
+
+		for (int i = 0; i < _dimensions; ++i)
+			sum += (a[i] - b[i]) * (a[i] - b[i]);
+
+		return sum;
+	}
+
+	//implicit k-d tree: the median of every range is its node, split dimensions cycle with the depth
+	void build(const size_t begin, const size_t end, const int depth, const int parallelDepth)
+	{
+		if (end - begin < 2)
+			return;
+
+		const size_t median = begin + (end - begin) / 2;
+		const int dimension = depth % _dimensions;
+		std::nth_element(_points.begin() + begin, _points.begin() + median, _points.begin() + end,
+			[dimension](const Point& a, const Point& b) { return a.Coords[dimension] < b.Coords[dimension]; });
+
+		if (depth < parallelDepth && end - begin > PARALLEL_THRESHOLD)
+		{
+			auto left = std::async(std::launch::async, [&]() { build(begin, median, depth + 1, parallelDepth); });
+			build(median + 1, end, depth + 1, parallelDepth);
+			left.get();
+		}
+		else
+		{
+			build(begin, median, depth + 1, parallelDepth);
+			build(median + 1, end, depth + 1, parallelDepth);
+		}
+	}
+
+	void findNearest(const float* query, const size_t begin, const size_t end, const int depth, const size_t k, std::vector<Result>& heap) const
+	{
+		if (begin >= end)
+			return;
+
+		const size_t median = begin + (end - begin) / 2;
+		const Point& point = _points[median];
+		const float distance = squaredDistance(query, point.Coords);
+
+		if (heap.size() < k || distance < heap.front().Distance)
+		{
+			if (heap.size() == k)
+			{
+				std::pop_heap(heap.begin(), heap.end());
+				heap.pop_back();
+			}
+
+			heap.push_back({ point.Index, point.Rgba, distance });
+			std::push_heap(heap.begin(), heap.end());
+		}
+
+		const int dimension = depth % _dimensions;
+		const float delta = query[dimension] - point.Coords[dimension];
+		const bool leftFirst = delta < 0.0f;
+		findNearest(query, leftFirst ? begin : median + 1, leftFirst ? median : end, depth + 1, k, heap);
+
+		if (heap.size() < k || delta * delta < heap.front().Distance)
+			findNearest(query, leftFirst ? median + 1 : begin, leftFirst ? end : median, depth + 1, k, heap);
+	}
+
+	void findWithinRadius(const float* query, const size_t begin, const size_t end, const int depth, const float squaredRadius, std::vector<Result>& results) const
+	{
+		if (begin >= end)
+			return;
+
+		const size_t median = begin + (end - begin) / 2;
+		const Point& point = _points[median];
+		const float distance = squaredDistance(query, point.Coords);
+
+		if (distance <= squaredRadius)
+			results.push_back({ point.Index, point.Rgba, distance });
+
+		const int dimension = depth % _dimensions;
+		const float delta = query[dimension] - point.Coords[dimension];
+
+		if (delta <= 0.0f || delta * delta <= squaredRadius)
+			findWithinRadius(query, begin, median, depth + 1, squaredRadius, results);
+
+		if (delta >= 0.0f || delta * delta <= squaredRadius)
+			findWithinRadius(query, median + 1, end, depth + 1, squaredRadius, results);
+	}
+
+public:
+	LitColorIndex(const int space = SPACE_RGB) : _space(space), _dimensions(space == SPACE_RGBA ? 4 : 3) {}
+
+	//CIE L*a*b* of an sRGB color, D65 white point
+	static void ToLab(const uint32_t rgba, float* lab)
+	{
+		const float r = linearize(static_cast<float>(rgba >> 24) / 255.0f);
+		const float g = linearize(static_cast<float>((rgba >> 16) & 0xFF) / 255.0f);
+		const float b = linearize(static_cast<float>((rgba >> 8) & 0xFF) / 255.0f);
+		const float x = labCurve((0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f);
+		const float y = labCurve(0.2126f * r + 0.7152f * g + 0.0722f * b);
+		const float z = labCurve((0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f);
+		lab[0] = 116.0f * y - 16.0f;
+		lab[1] = 500.0f * (x - y);
+		lab[2] = 200.0f * (y - z);
+	}
+
+	//Index of each Result refers to the position within rgba
+	void Build(const uint32_t* rgba, const size_t count, unsigned int threadCount = 0)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		_points.resize(count);
+		const size_t chunk = (count + threadCount - 1) / threadCount;
+		std::vector<std::thread> workers;
+
+		for (size_t first = 0; first < count; first += chunk)
+		{
+			workers.emplace_back([this, rgba, first, last = std::min(first + chunk, count)]()
+			{
+				for (size_t i = first; i < last; ++i)
+				{
+					toCoords(rgba[i], _points[i].Coords);
+					_points[i].Rgba = rgba[i];
+					_points[i].Index = i;
+				}
+			});
+		}
+
+		for (auto& thread : workers)
+			thread.join();
+
+		int parallelDepth = 0;
+
+		while ((1u << parallelDepth) < threadCount)
+			++parallelDepth;
+
+		build(0, _points.size(), 0, parallelDepth);
+	}
+
+	void Build(const std::vector<uint32_t>& rgba, const unsigned int threadCount = 0)
+	{
+		Build(rgba.data(), rgba.size(), threadCount);
+	}
+
+	void Build(const std::vector<LitColor>& colors, const unsigned int threadCount = 0)
+	{
+		std::vector<uint32_t> rgba(colors.size());
+
+		for (size_t i = 0; i < colors.size(); ++i)
+			rgba[i] = colors[i].GetRGBA();
+
+		Build(rgba, threadCount);
+	}
+
+	size_t GetSize() const
+	{
+		return _points.size();
+	}
+
+	int GetSpace() const
+	{
+		return _space;
+	}
+
+	//closest first. Distances are euclidean within the index' color space
+	std::vector<Result> FindNearest(const LitColor& reference, const size_t k = 1) const
+	{
+		std::vector<Result> heap;
+
+		if (k == 0)
+			return heap;
+
+		float query[4];
+		toCoords(reference.GetRGBA(), query);
+		heap.reserve(k + 1);
+		findNearest(query, 0, _points.size(), 0, k, heap);
+		std::sort_heap(heap.begin(), heap.end());
+
+		for (auto& result : heap)
+			result.Distance = std::sqrt(result.Distance);
+
+		return heap;
+	}
+
+	std::vector<Result> FindWithinRadius(const LitColor& reference, const float radius) const
+	{
+		std::vector<Result> results;
+		float query[4];
+		toCoords(reference.GetRGBA(), query);
+		findWithinRadius(query, 0, _points.size(), 0, radius * radius, results);
+		std::sort(results.begin(), results.end());
+
+		for (auto& result : results)
+			result.Distance = std::sqrt(result.Distance);
+
+		return results;
+	}
+};
@@ -0,0 +1,417 @@
+﻿#pragma once
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "LitColorProcess.h"
+
+class LitColorLiveScan
+{
+private:
+	static constexpr uint64_t PAGEMAP_SOFT_DIRTY = 1ull << 55;
+
+	//PAGEMAP_SCAN of Linux 6.7, declared here since older headers lack it
+	struct pageRegion
+	{
+		uint64_t Begin;
+		uint64_t End;
+		uint64_t Categories;
+	};
+
+	struct pageScanArgs
+	{
+		uint64_t Size;
+		uint64_t Flags;
+		uint64_t Begin;
+		uint64_t End;
+		uint64_t WalkEnd;
+		uint64_t Regions;
+		uint64_t RegionCount;
+		uint64_t MaxPages;
+		uint64_t CategoryInverted;
+		uint64_t CategoryMask;
+		uint64_t CategoryAnyOfMask;
+		uint64_t ReturnMask;
+	};
+
+	static constexpr unsigned long PAGEMAP_SCAN = _IOWR('f', 16, pageScanArgs);
+	static constexpr uint64_t PM_SCAN_WP_MATCHING = 1;
+	static constexpr uint64_t PM_SCAN_CHECK_WPASYNC = 2;
+	static constexpr uint64_t PAGE_IS_WRITTEN = 2;
+
+	LitColorProcess _process;
+	LitColorScanner _scanner;
+	std::vector<LitColorMemoryRegion> _regions;
+	std::vector<LitColorMemoryRegion> _dirtyRanges;
+	std::vector<LitColorMemoryRegion> _replacedRanges; //old hits starting in here are replaced by the rescan
+	std::vector<LitColorMemoryRegion> _softDirtyPages; //pages seen soft-dirty by the previous update, rescanned once more
+	std::vector<uint64_t> _pagemapEntries;
+	std::vector<pageRegion> _writtenPages;
+	std::vector<LitColorHit> _hits;
+	std::vector<LitColorHit> _merged;
+	uint64_t _pageSize = 0x1000;
+	uint64_t _lastScannedBytes = 0;
+	bool _initialized = false;
+	bool _softDirtyAvailable = true;
+
+	bool clearSoftDirty()
+	{
+		const int fd = open(("/proc/" + std::to_string(_process.GetPid()) + "/clear_refs").c_str(), O_WRONLY);
+
+		if (fd < 0)
+			return false;
+
+		const bool success = write(fd, "4", 1) == 1;
+		close(fd);
+		return success;
+	}
+
+	static bool containsRegion(const std::vector<LitColorMemoryRegion>& regions, const LitColorMemoryRegion& region)
+	{
+		for (const auto& known : regions)
+			if (known.Begin == region.Begin && known.End == region.End)
+				return true;
+
+		return false;
+	}
+
+	static void appendRange(std::vector<LitColorMemoryRegion>& ranges, const LitColorMemoryRegion& region, const uint64_t begin, const uint64_t end)
+	{
+		if (!ranges.empty() && ranges.back().End >= begin)
+			ranges.back().End = std::max(ranges.back().End, end);
+		else
+			ranges.push_back({ begin, end, region.Writable, region.Path });
+	}
+
+	void addWholeRegion(const LitColorMemoryRegion& region)
+	{
+		_dirtyRanges.push_back(region);
+		_replacedRanges.push_back(region);
+	}
+
+	void addDirtyRange(const LitColorMemoryRegion& region, uint64_t begin, const uint64_t end)
+	{
+		//values may straddle a page boundary, so the rescan starts one value early and reads one value past the end.
+		//It only finds values starting before end though, hits starting on the following clean page are kept
+		const uint64_t typeSize = _scanner.GetValueSize();
+		const uint64_t alignment = _scanner.GetAlignment();
+		const uint64_t back = (typeSize - 1 + alignment - 1) / alignment * alignment;
+		begin = begin - region.Begin >= back ? begin - back : region.Begin;
+		appendRange(_dirtyRanges, region, begin, std::min(end + typeSize - 1, region.End));
+		appendRange(_replacedRanges, region, begin, end);
+	}
+
+	//written pages of a region the target registered for asynchronous userfaultfd write protection. The pages are reported and
+	//protected again in one step, so no write is lost. False if the region isn't registered or the kernel lacks PAGEMAP_SCAN
+	bool collectWrittenPages(const int fd, const LitColorMemoryRegion& region)
+	{
+		_writtenPages.resize(256);
+		uint64_t begin = region.Begin;
+		const size_t rangeCount = _dirtyRanges.size();
+
+		while (begin < region.End)
+		{
+			pageScanArgs args = {};
+			args.Size = sizeof(args);
+			args.Flags = PM_SCAN_WP_MATCHING | PM_SCAN_CHECK_WPASYNC;
+			args.Begin = begin;
+			args.End = region.End;
+			args.Regions = reinterpret_cast<uintptr_t>(_writtenPages.data());
+			args.RegionCount = _writtenPages.size();
+			args.CategoryMask = PAGE_IS_WRITTEN;
+			args.ReturnMask = PAGE_IS_WRITTEN;
+			const int count = ioctl(fd, PAGEMAP_SCAN, &args);
+
+			if (count < 0)
+			{
+				//only the first call may fail, later ones would have lost pages that are protected again already
+				if (begin == region.Begin)
+					return false;
+
+				_dirtyRanges.resize(rangeCount);
+				_replacedRanges.resize(rangeCount);
+				addWholeRegion(region);
+				return true;
+			}
+
+			for (int i = 0; i < count; ++i)
+				addDirtyRange(region, _writtenPages[i].Begin, _writtenPages[i].End);
+
+			if (args.WalkEnd <= begin)
+				break;
+
+			begin = args.WalkEnd;
+		}
+
+		return true;
+	}
+
+	//soft-dirty bits are read here and cleared later by clearSoftDirty(). A write in between is cleared without being seen,
+	//so pages dirty on the previous update are rescanned as well: pages written once are likely written again
+	bool collectDirtyRanges(const std::vector<LitColorMemoryRegion>& regions)
+	{
+		const int fd = open(("/proc/" + std::to_string(_process.GetPid()) + "/pagemap").c_str(), O_RDONLY);
+
+		if (fd < 0)
+			return false;
+
+		_dirtyRanges.clear();
+		_replacedRanges.clear();
+		std::vector<LitColorMemoryRegion> softDirtyPages;
+		size_t previousCursor = 0;
+
+		for (const auto& region : regions)
+		{
+			if (!containsRegion(_regions, region))
+			{
+				addWholeRegion(region);
+				continue;
+			}
+
+			if (collectWrittenPages(fd, region))
+				continue;
+
+			if (!_softDirtyAvailable)
+			{
+				addWholeRegion(region);
+				continue;
+			}
+
+			const uint64_t pageCount = region.GetSize() / _pageSize;
+			_pagemapEntries.resize(pageCount);
+			const ssize_t expected = static_cast<ssize_t>(pageCount * sizeof(uint64_t));
+
+			if (pread(fd, _pagemapEntries.data(), expected, region.Begin / _pageSize * sizeof(uint64_t)) != expected)
+			{
+				addWholeRegion(region);
+				continue;
+			}
+
+			for (uint64_t page = 0; page < pageCount; ++page)
+				if (_pagemapEntries[page] & PAGEMAP_SOFT_DIRTY)
+					appendRange(softDirtyPages, region, region.Begin + page * _pageSize, region.Begin + (page + 1) * _pageSize);
+
+			while (previousCursor < _softDirtyPages.size() && _softDirtyPages[previousCursor].End <= region.Begin)
+				++previousCursor;
+
+			for (size_t previous = previousCursor; previous < _softDirtyPages.size() && _softDirtyPages[previous].Begin < region.End; ++previous)
+				for (uint64_t address = std::max(_softDirtyPages[previous].Begin, region.Begin); address < std::min(_softDirtyPages[previous].End, region.End); address += _pageSize)
+					_pagemapEntries[(address - region.Begin) / _pageSize] |= PAGEMAP_SOFT_DIRTY;
+
+			for (uint64_t page = 0; page < pageCount; ++page)
+			{
+				if (!(_pagemapEntries[page] & PAGEMAP_SOFT_DIRTY))
+					continue;
+
+				uint64_t last = page;
+
+				while (last + 1 < pageCount && (_pagemapEntries[last + 1] & PAGEMAP_SOFT_DIRTY))
+					++last;
+
+				addDirtyRange(region, region.Begin + page * _pageSize, region.Begin + (last + 1) * _pageSize);
+				page = last;
+			}
+		}
+
+		close(fd);
+		_softDirtyPages.swap(softDirtyPages);
+		return true;
+	}
+
+	//protects the written pages of registered regions again, see collectWrittenPages()
+	void resetWrittenPages(const std::vector<LitColorMemoryRegion>& regions)
+	{
+		const int fd = open(("/proc/" + std::to_string(_process.GetPid()) + "/pagemap").c_str(), O_RDONLY);
+
+		if (fd < 0)
+			return;
+
+		for (const auto& region : regions)
+		{
+			pageScanArgs args = {};
+			args.Size = sizeof(args);
+			args.Flags = PM_SCAN_WP_MATCHING | PM_SCAN_CHECK_WPASYNC;
+			args.Begin = region.Begin;
+			args.End = region.End;
+			args.CategoryMask = PAGE_IS_WRITTEN;
+			ioctl(fd, PAGEMAP_SCAN, &args);
+		}
+
+		close(fd);
+	}
+
+	static bool isInside(const uint64_t address, const std::vector<LitColorMemoryRegion>& ranges, size_t& cursor)
+	{
+		while (cursor < ranges.size() && ranges[cursor].End <= address)
+			++cursor;
+
+		return cursor < ranges.size() && ranges[cursor].Begin <= address;
+	}
+
+	void mergeHits(const std::vector<LitColorMemoryRegion>& regions, std::vector<LitColorHit>& freshHits)
+	{
+		_merged.clear();
+		size_t regionCursor = 0;
+		size_t replacedCursor = 0;
+
+		//keep old hits that are still mapped and weren't rescanned
+		for (const auto& hit : _hits)
+			if (isInside(hit.Address, regions, regionCursor) && !isInside(hit.Address, _replacedRanges, replacedCursor))
+				_merged.push_back(hit);
+
+		_merged.insert(_merged.end(), freshHits.begin(), freshHits.end());
+		std::sort(_merged.begin(), _merged.end());
+		_hits.swap(_merged);
+	}
+
+	std::vector<LitColorMemoryRegion> getSortedRegions() const
+	{
+		std::vector<LitColorMemoryRegion> regions = _process.GetRegions(true);
+		std::sort(regions.begin(), regions.end(), [](const auto& a, const auto& b) { return a.Begin < b.Begin; });
+		return regions;
+	}
+
+	void addAllRegions(const std::vector<LitColorMemoryRegion>& regions)
+	{
+		_dirtyRanges = regions;
+		_replacedRanges = regions;
+	}
+
+	const std::vector<LitColorHit>& rescan(std::vector<LitColorMemoryRegion>& regions, std::shared_ptr<LitColorScanProgress> progress)
+	{
+		_lastScannedBytes = 0;
+
+		for (const auto& range : _dirtyRanges)
+			_lastScannedBytes += range.GetSize();
+
+		std::vector<LitColorHit> freshHits = _process.Scan(_scanner, _dirtyRanges, progress);
+
+		if (progress && progress->IsCancelled())
+		{
+			//the dirty bits are gone already, the next update has to rescan everything
+			_initialized = false;
+			return _hits;
+		}
+
+		mergeHits(regions, freshHits);
+		_regions.swap(regions);
+		_initialized = true;
+		return _hits;
+	}
+
+public:
+	LitColorLiveScan(const pid_t pid, const LitColorScanner& scanner)
+		: _process(pid), _scanner(scanner)
+	{
+		_pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+		_softDirtyAvailable = IsSoftDirtySupported();
+	}
+
+	static bool IsSoftDirtySupported()
+	{
+		//kernels without CONFIG_MEM_SOFT_DIRTY accept clear_refs but never set the bit, freshly mapped pages always have it otherwise
+		const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		void* page = mmap(nullptr, pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (page == MAP_FAILED)
+			return false;
+
+		*static_cast<volatile uint8_t*>(page) = 1;
+		uint64_t entry = 0;
+		const int fd = open("/proc/self/pagemap", O_RDONLY);
+
+		if (fd >= 0)
+		{
+			if (pread(fd, &entry, sizeof(entry), reinterpret_cast<uintptr_t>(page) / pageSize * sizeof(entry)) != sizeof(entry))
+				entry = 0;
+
+			close(fd);
+		}
+
+		munmap(page, pageSize);
+		return (entry & PAGEMAP_SOFT_DIRTY) != 0;
+	}
+
+	const std::vector<LitColorHit>& Update(std::shared_ptr<LitColorScanProgress> progress = nullptr)
+	{
+		std::vector<LitColorMemoryRegion> regions = getSortedRegions();
+
+		//dirty pages are collected and marked clean before the pages are read, so writes during the scan show up next time
+		if (!_initialized || !collectDirtyRanges(regions))
+		{
+			addAllRegions(regions);
+			_softDirtyPages.clear();
+			resetWrittenPages(regions);
+		}
+
+		if (_softDirtyAvailable)
+			_softDirtyAvailable = clearSoftDirty();
+
+		return rescan(regions, progress);
+	}
+
+	//rescans the pages overlapping writtenRanges instead of reading soft-dirty bits, e.g. for callers that know what was written
+	const std::vector<LitColorHit>& Update(std::vector<LitColorMemoryRegion> writtenRanges, std::shared_ptr<LitColorScanProgress> progress = nullptr)
+	{
+		std::vector<LitColorMemoryRegion> regions = getSortedRegions();
+		std::sort(writtenRanges.begin(), writtenRanges.end(), [](const auto& a, const auto& b) { return a.Begin < b.Begin; });
+
+		if (!_initialized)
+		{
+			addAllRegions(regions);
+			return rescan(regions, progress);
+		}
+
+		_dirtyRanges.clear();
+		_replacedRanges.clear();
+
+		for (const auto& region : regions)
+		{
+			if (!containsRegion(_regions, region))
+			{
+				addWholeRegion(region);
+				continue;
+			}
+
+			for (const auto& written : writtenRanges)
+			{
+				const uint64_t begin = std::max(written.Begin, region.Begin) / _pageSize * _pageSize;
+				const uint64_t end = std::min((std::min(written.End, region.End) + _pageSize - 1) / _pageSize * _pageSize, region.End);
+
+				if (begin < end && written.End > region.Begin && written.Begin < region.End)
+					addDirtyRange(region, begin, end);
+			}
+		}
+
+		return rescan(regions, progress);
+	}
+
+	void Reset()
+	{
+		_initialized = false;
+		_regions.clear();
+		_softDirtyPages.clear();
+		_hits.clear();
+	}
+
+	const std::vector<LitColorHit>& GetHits() const
+	{
+		return _hits;
+	}
+
+	uint64_t GetLastScannedBytes() const
+	{
+		return _lastScannedBytes;
+	}
+
+	bool IsSoftDirtyAvailable() const
+	{
+		return _softDirtyAvailable;
+	}
+};
+
+#endif
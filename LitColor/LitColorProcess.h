@@ -0,0 +1,238 @@
+﻿#pragma once
+
+#ifdef __linux__
+
+#include <climits>
+#include <fstream>
+#include <string>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "LitColorScanner.h"
+
+struct LitColorMemoryRegion
+{
+	uint64_t Begin = 0;
+	uint64_t End = 0;
+	bool Writable = false;
+	std::string Path;
+
+	uint64_t GetSize() const
+	{
+		return End - Begin;
+	}
+};
+
+class LitColorProcess
+{
+private:
+	struct Piece
+	{
+		uint64_t Address;
+		size_t ReadSize;
+		size_t ScanSize;
+		size_t BufferOffset;
+	};
+
+	pid_t _pid = 0;
+	size_t _batchSize = 0x1000000;
+	std::vector<uint8_t> _buffer;
+	uint8_t* _externalBuffer = nullptr;
+	size_t _externalBufferSize = 0;
+	uint8_t* _bufferData = nullptr;
+	size_t _bufferCapacity = 0;
+	std::vector<iovec> _localIovs;
+	std::vector<iovec> _remoteIovs;
+	std::vector<Piece> _pieces;
+
+	bool readPieces()
+	{
+		_localIovs.clear();
+		_remoteIovs.clear();
+
+		for (const auto& p : _pieces)
+		{
+			_localIovs.push_back({ _bufferData + p.BufferOffset, p.ReadSize });
+			_remoteIovs.push_back({ reinterpret_cast<void*>(p.Address), p.ReadSize });
+		}
+
+		const ssize_t expected = static_cast<ssize_t>(_pieces.back().BufferOffset + _pieces.back().ReadSize);
+		const ssize_t result = process_vm_readv(_pid, _localIovs.data(), _localIovs.size(), _remoteIovs.data(), _remoteIovs.size(), 0);
+
+		if (result == expected)
+			return true;
+
+		//a region vanished or isn't readable after all, retry piece by piece and drop the failing ones
+		std::vector<Piece> readable;
+
+		for (size_t i = 0; i < _pieces.size(); ++i)
+			if (process_vm_readv(_pid, &_localIovs[i], 1, &_remoteIovs[i], 1, 0) == static_cast<ssize_t>(_pieces[i].ReadSize))
+				readable.push_back(_pieces[i]);
+
+		_pieces.swap(readable);
+		return !_pieces.empty();
+	}
+
+	template<typename Callback> void forEachBatch(const std::vector<LitColorMemoryRegion>& regions, const size_t overlap, const uint32_t alignment, Callback callback)
+	{
+		const size_t batchSize = _externalBuffer ? _externalBufferSize - std::min(overlap, _externalBufferSize) : _batchSize;
+		const size_t maxPieceSize = std::max<size_t>(batchSize - batchSize % alignment, alignment);
+
+		if (_externalBuffer && maxPieceSize + overlap <= _externalBufferSize)
+		{
+			_bufferData = _externalBuffer;
+			_bufferCapacity = _externalBufferSize;
+		}
+		else
+		{
+			_buffer.resize(maxPieceSize + overlap);
+			_bufferData = _buffer.data();
+			_bufferCapacity = _buffer.size();
+		}
+
+		_pieces.clear();
+		size_t used = 0;
+		bool proceed = true;
+
+		auto flush = [&]()
+		{
+			if (!_pieces.empty() && readPieces())
+				proceed = callback(_bufferData, _pieces);
+
+			_pieces.clear();
+			used = 0;
+		};
+
+		for (const auto& region : regions)
+		{
+			for (uint64_t address = region.Begin; address < region.End; address += maxPieceSize)
+			{
+				const size_t scanSize = static_cast<size_t>(std::min<uint64_t>(maxPieceSize, region.End - address));
+				const size_t readSize = static_cast<size_t>(std::min<uint64_t>(scanSize + overlap, region.End - address));
+
+				if (used + readSize > _bufferCapacity || _pieces.size() >= IOV_MAX)
+					flush();
+
+				if (!proceed)
+					return;
+
+				_pieces.push_back({ address, readSize, scanSize, used });
+				used += readSize;
+			}
+		}
+
+		flush();
+	}
+
+public:
+	LitColorProcess(const pid_t pid) : _pid(pid) {}
+
+	pid_t GetPid() const
+	{
+		return _pid;
+	}
+
+	void SetBatchSize(const size_t batchSize)
+	{
+		_batchSize = std::max<size_t>(batchSize, 0x1000);
+	}
+
+	//reads into buffer instead of an internal one, e.g. huge pages owned by a LitColorScanSession. nullptr switches back
+	void SetBuffer(uint8_t* buffer, const size_t size)
+	{
+		_externalBuffer = buffer;
+		_externalBufferSize = buffer ? size : 0;
+	}
+
+	static std::vector<LitColorMemoryRegion> GetRegions(const pid_t pid, const bool writableOnly = false)
+	{
+		std::vector<LitColorMemoryRegion> regions;
+		std::ifstream maps("/proc/" + std::to_string(pid) + "/maps");
+		std::string line;
+
+		while (std::getline(maps, line))
+		{
+			std::stringstream stream(line);
+			std::string range, perms, offset, device, inode;
+			LitColorMemoryRegion region;
+			stream >> range >> perms >> offset >> device >> inode;
+			std::getline(stream >> std::ws, region.Path);
+
+			if (perms.size() < 2 || perms[0] != 'r')
+				continue;
+
+			region.Writable = perms[1] == 'w';
+
+			if (writableOnly && !region.Writable)
+				continue;
+
+			if (region.Path == "[vvar]" || region.Path == "[vsyscall]")
+				continue;
+
+			const size_t dash = range.find('-');
+			region.Begin = std::stoull(range.substr(0, dash), nullptr, 16);
+			region.End = std::stoull(range.substr(dash + 1), nullptr, 16);
+			regions.push_back(region);
+		}
+
+		return regions;
+	}
+
+	std::vector<LitColorMemoryRegion> GetRegions(const bool writableOnly = false) const
+	{
+		return GetRegions(_pid, writableOnly);
+	}
+
+	size_t Read(const uint64_t address, void* out, const size_t size) const
+	{
+		iovec local = { out, size };
+		iovec remote = { reinterpret_cast<void*>(address), size };
+		const ssize_t result = process_vm_readv(_pid, &local, 1, &remote, 1, 0);
+		return result < 0 ? 0 : static_cast<size_t>(result);
+	}
+
+	//appends to hits, which keeps its capacity between scans
+	void Scan(const LitColorScanner& scanner, const std::vector<LitColorMemoryRegion>& regions, std::vector<LitColorHit>& hits, std::shared_ptr<LitColorScanProgress> progress = nullptr)
+	{
+		uint64_t total = 0;
+
+		for (const auto& region : regions)
+			total += region.GetSize();
+
+		if (progress)
+			progress->Reset(total);
+
+		forEachBatch(regions, scanner.GetValueSize() - 1, scanner.GetAlignment(),
+			[&](const uint8_t* buffer, const std::vector<Piece>& pieces)
+		{
+			for (const auto& p : pieces)
+			{
+				if (progress && progress->IsCancelled())
+					return false;
+
+				scanner.ScanRange(buffer + p.BufferOffset, p.ReadSize, 0, p.ScanSize, p.Address, hits);
+
+				if (progress)
+					progress->AddBytesProcessed(p.ScanSize);
+			}
+
+			return true;
+		});
+
+		if (progress)
+			progress->SetFinished();
+	}
+
+	std::vector<LitColorHit> Scan(const LitColorScanner& scanner, const std::vector<LitColorMemoryRegion>& regions, std::shared_ptr<LitColorScanProgress> progress = nullptr)
+	{
+		std::vector<LitColorHit> hits;
+		Scan(scanner, regions, hits, progress);
+		return hits;
+	}
+
+	std::vector<LitColorHit> Scan(const LitColorScanner& scanner, std::shared_ptr<LitColorScanProgress> progress = nullptr)
+	{
+		return Scan(scanner, GetRegions(true), progress);
+	}
+};
+
+#endif
@@ -0,0 +1,497 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "LitColor.h"
+
+class LitColorQuery
+{
+public:
+	enum Modes
+	{
+		EXACT,
+		IGNORE_ALPHA,
+		CHANNEL_MASK,
+		RANGE,
+		TOLERANCE
+	};
+
+	enum Channels
+	{
+		CHANNEL_RED = 1 << LitColor::RED,
+		CHANNEL_GREEN = 1 << LitColor::GREEN,
+		CHANNEL_BLUE = 1 << LitColor::BLUE,
+		CHANNEL_ALPHA = 1 << LitColor::ALPHA,
+		CHANNEL_RGB = CHANNEL_RED | CHANNEL_GREEN | CHANNEL_BLUE,
+		CHANNEL_RGBA = CHANNEL_RGB | CHANNEL_ALPHA
+	};
+
+private:
+	int _type = LitColor::RGBA8888;
+	int _mode = EXACT;
+	bool _bigEndian = true;
+	int _channels = CHANNEL_RGBA;
+	uint32_t _key = 0;
+	uint32_t _mask = 0xFFFFFFFF;
+	int32_t _min[4] = { 0, 0, 0, 0 };
+	int32_t _max[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+
+	static bool isHostBigEndian()
+	{
+		const uint16_t probe = 1;
+		return *reinterpret_cast<const uint8_t*>(&probe) == 0;
+	}
+
+	static uint32_t load32(const uint8_t* ptr, const bool bigEndian)
+	{
+		uint32_t val;
+		std::memcpy(&val, ptr, sizeof(val));
+
+		if (bigEndian != isHostBigEndian())
+			val = (val >> 24) | ((val >> 8) & 0xFF00) | ((val << 8) & 0xFF0000) | (val << 24);
+
+		return val;
+	}
+
+	static uint16_t load16(const uint8_t* ptr, const bool bigEndian)
+	{
+		uint16_t val;
+		std::memcpy(&val, ptr, sizeof(val));
+
+		if (bigEndian != isHostBigEndian())
+			val = static_cast<uint16_t>((val >> 8) | (val << 8));
+
+		return val;
+	}
+
+	static bool isColorFloat(const float val)
+	{
+		return val >= 0.0f && val <= 1.0f; //also false for NaN
+	}
+
+	static int usedChannels(const int type, const int channels)
+	{
+		if (type == LitColor::RGB888 || type == LitColor::RGBF || type == LitColor::RGB565)
+			return channels & CHANNEL_RGB;
+
+		return channels;
+	}
+
+	static uint32_t rgbaMask(const int channels)
+	{
+		uint32_t mask = 0;
+
+		if (channels & CHANNEL_RED)
+			mask |= 0xFF000000;
+		if (channels & CHANNEL_GREEN)
+			mask |= 0x00FF0000;
+		if (channels & CHANNEL_BLUE)
+			mask |= 0x0000FF00;
+		if (channels & CHANNEL_ALPHA)
+			mask |= 0x000000FF;
+
+		return mask;
+	}
+
+	void compileWordCompare(const LitColor& target)
+	{
+		const int channels = usedChannels(_type, _channels);
+
+		switch (_type)
+		{
+		case LitColor::RGB565: {
+			_key = target.GetRGB565();
+			_mask = (channels & CHANNEL_RED ? 0xF800 : 0) | (channels & CHANNEL_GREEN ? 0x07E0 : 0) | (channels & CHANNEL_BLUE ? 0x001F : 0);
+		} break;
+		case LitColor::RGB5A3: {
+			_key = target.GetRGB5A3();
+
+			if (_key & 0x8000) //opaque, no alpha bits
+				_mask = 0x8000 | (channels & CHANNEL_RED ? 0x7C00 : 0) | (channels & CHANNEL_GREEN ? 0x03E0 : 0) | (channels & CHANNEL_BLUE ? 0x001F : 0);
+			else
+				_mask = 0x8000 | (channels & CHANNEL_ALPHA ? 0x7000 : 0) | (channels & CHANNEL_RED ? 0x0F00 : 0) | (channels & CHANNEL_GREEN ? 0x00F0 : 0) | (channels & CHANNEL_BLUE ? 0x000F : 0);
+		} break;
+		case LitColor::RGBA16F: {
+			//compare against the target as stored in half precision, 0.9 becomes 0.8999 which maps to 229 rather than 230
+			LitColor color = target;
+			uint16_t halves[4];
+
+			for (int i = LitColor::RED; i <= LitColor::ALPHA; ++i)
+				halves[i] = LitColor::FloatToHalf(color.GetColorValue<float>(i));
+
+			_key = LitColor::RGBA16FToRGBA8888(halves);
+			_mask = rgbaMask(channels);
+		} break;
+		default: {
+			_key = target.GetRGBA();
+			_mask = rgbaMask(channels);
+		}
+		}
+
+		_key &= _mask;
+	}
+
+	static uint32_t expandRgb5A3(const uint16_t val)
+	{
+		if (val & 0x8000)
+			return LitColor::RGB5A3ToRGB888(val) | 0xFF;
+
+		return LitColor::RGB5A3ToRGBA8888(val);
+	}
+
+	bool inRange(const uint32_t rgba) const
+	{
+		return static_cast<int32_t>(rgba >> 24) >= _min[LitColor::RED] && static_cast<int32_t>(rgba >> 24) <= _max[LitColor::RED]
+			&& static_cast<int32_t>((rgba >> 16) & 0xFF) >= _min[LitColor::GREEN] && static_cast<int32_t>((rgba >> 16) & 0xFF) <= _max[LitColor::GREEN]
+			&& static_cast<int32_t>((rgba >> 8) & 0xFF) >= _min[LitColor::BLUE] && static_cast<int32_t>((rgba >> 8) & 0xFF) <= _max[LitColor::BLUE]
+			&& static_cast<int32_t>(rgba & 0xFF) >= _min[LitColor::ALPHA] && static_cast<int32_t>(rgba & 0xFF) <= _max[LitColor::ALPHA];
+	}
+
+	void compileChannelRange(const uint32_t minRgba, const uint32_t maxRgba)
+	{
+		const int channels = usedChannels(_type, _channels);
+
+		for (int i = LitColor::RED; i <= LitColor::ALPHA; ++i)
+		{
+			const int shift = 24 - i * 8;
+			_min[i] = (channels & (1 << i)) ? static_cast<int32_t>((minRgba >> shift) & 0xFF) : 0;
+			_max[i] = (channels & (1 << i)) ? static_cast<int32_t>((maxRgba >> shift) & 0xFF) : 0xFF;
+		}
+	}
+
+	LitColorQuery(const int type, const int mode, const bool bigEndian, const int channels)
+		: _type(type), _mode(mode), _bigEndian(bigEndian), _channels(channels) {}
+
+public:
+	LitColorQuery(const LitColor& target, const int type, const int mode = EXACT, const bool bigEndian = true)
+		: LitColorQuery(type, mode, bigEndian, mode == IGNORE_ALPHA ? CHANNEL_RGB : CHANNEL_RGBA)
+	{
+		if (mode == EXACT && !target.UsesAlpha())
+			_channels = CHANNEL_RGB;
+
+		if (mode == RANGE || mode == TOLERANCE)
+			compileChannelRange(target.GetRGBA(), target.GetRGBA());
+		else
+			compileWordCompare(target);
+	}
+
+	static LitColorQuery Masked(const LitColor& target, const int type, const int channels, const bool bigEndian = true)
+	{
+		LitColorQuery query(type, CHANNEL_MASK, bigEndian, channels);
+		query.compileWordCompare(target);
+		return query;
+	}
+
+	static LitColorQuery Range(const LitColor& min, const LitColor& max, const int type, const bool bigEndian = true, const int channels = CHANNEL_RGBA)
+	{
+		LitColorQuery query(type, RANGE, bigEndian, channels);
+		query.compileChannelRange(min.GetRGBA(), max.GetRGBA());
+		return query;
+	}
+
+	static LitColorQuery Tolerance(const LitColor& target, const int type, const uint8_t tolerance, const bool bigEndian = true, const int channels = CHANNEL_RGBA)
+	{
+		LitColorQuery query(type, TOLERANCE, bigEndian, channels);
+		query.compileChannelRange(target.GetRGBA(), target.GetRGBA());
+
+		for (int i = LitColor::RED; i <= LitColor::ALPHA; ++i)
+		{
+			if (!(usedChannels(type, channels) & (1 << i)))
+				continue;
+
+			query._min[i] = std::max(0, query._min[i] - tolerance);
+			query._max[i] = std::min(0xFF, query._max[i] + tolerance);
+		}
+
+		return query;
+	}
+
+	int GetType() const
+	{
+		return _type;
+	}
+
+	int GetMode() const
+	{
+		return _mode;
+	}
+
+	bool IsBigEndian() const
+	{
+		return _bigEndian;
+	}
+
+	//raw word for packed 16 bit formats, RGBA8888 otherwise. Returns false for float channels out of 0.0 - 1.0
+	template<int Type> bool LoadWord(const uint8_t* ptr, uint32_t& word) const
+	{
+		if constexpr (Type == LitColor::RGB888)
+		{
+			word = static_cast<uint32_t>(ptr[0]) << 24 | static_cast<uint32_t>(ptr[1]) << 16 | static_cast<uint32_t>(ptr[2]) << 8 | 0xFF;
+		}
+		else if constexpr (Type == LitColor::RGBA8888)
+		{
+			word = load32(ptr, _bigEndian);
+		}
+		else if constexpr (Type == LitColor::RGBF || Type == LitColor::RGBAF)
+		{
+			float channels[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+			for (int i = 0; i < (Type == LitColor::RGBAF ? 4 : 3); ++i)
+			{
+				const uint32_t raw = load32(ptr + i * sizeof(float), _bigEndian);
+				std::memcpy(&channels[i], &raw, sizeof(float));
+
+				if (!isColorFloat(channels[i]))
+					return false;
+			}
+
+			word = LitColor::RGBAFToRGBA8888(channels);
+		}
+		else if constexpr (Type == LitColor::RGBA16F)
+		{
+			uint64_t raw;
+			std::memcpy(&raw, ptr, sizeof(raw));
+
+			if (_bigEndian != isHostBigEndian())
+				raw = ((raw >> 8) & 0x00FF00FF00FF00FF) | ((raw & 0x00FF00FF00FF00FF) << 8);
+
+			//rejects all four halves at once unless each is positive and at most 1.0 (0x3C00). Lanes below 0x8000 cannot carry into their neighbour
+			if ((raw | (raw + 0x43FF43FF43FF43FF)) & 0x8000800080008000)
+				return false;
+
+			uint16_t halves[4];
+			std::memcpy(halves, &raw, sizeof(halves));
+			word = LitColor::RGBA16FToRGBA8888(halves);
+		}
+		else
+		{
+			word = load16(ptr, _bigEndian);
+		}
+
+		return true;
+	}
+
+	template<int Type> bool Matches(const uint8_t* ptr) const
+	{
+		uint32_t word;
+
+		if (!LoadWord<Type>(ptr, word))
+			return false;
+
+		if (_mode != RANGE && _mode != TOLERANCE)
+			return (word & _mask) == _key;
+
+		if constexpr (Type == LitColor::RGB565)
+			return inRange(LitColor::RGB565ToRGB888(static_cast<uint16_t>(word)));
+		else if constexpr (Type == LitColor::RGB5A3)
+			return inRange(expandRgb5A3(static_cast<uint16_t>(word)));
+		else
+			return inRange(word);
+	}
+
+	bool Matches(const uint8_t* ptr) const
+	{
+		switch (_type)
+		{
+		case LitColor::RGB888: return Matches<LitColor::RGB888>(ptr);
+		case LitColor::RGBA8888: return Matches<LitColor::RGBA8888>(ptr);
+		case LitColor::RGBF: return Matches<LitColor::RGBF>(ptr);
+		case LitColor::RGBAF: return Matches<LitColor::RGBAF>(ptr);
+		case LitColor::RGBA16F: return Matches<LitColor::RGBA16F>(ptr);
+		case LitColor::RGB5A3: return Matches<LitColor::RGB5A3>(ptr);
+		default: return Matches<LitColor::RGB565>(ptr);
+		}
+	}
+
+	template<int Type, typename Callback> void ForEachMatch(const uint8_t* data, const size_t begin, const size_t last, const uint32_t alignment, Callback callback) const
+	{
+		if (_mode == RANGE || _mode == TOLERANCE)
+		{
+			for (size_t offset = begin; offset < last; offset += alignment)
+				if (Matches<Type>(data + offset))
+					callback(offset);
+
+			return;
+		}
+
+		const uint32_t key = _key;
+		const uint32_t mask = _mask;
+		uint32_t word;
+
+		for (size_t offset = begin; offset < last; offset += alignment)
+			if (LoadWord<Type>(data + offset, word) && (word & mask) == key)
+				callback(offset);
+	}
+
+	//calls callback(offset) for every match starting in [begin, last)
+	template<typename Callback> void ForEachMatch(const uint8_t* data, const size_t begin, const size_t last, const uint32_t alignment, Callback callback) const
+	{
+		switch (_type)
+		{
+		case LitColor::RGB888: ForEachMatch<LitColor::RGB888>(data, begin, last, alignment, callback); break;
+		case LitColor::RGBA8888: ForEachMatch<LitColor::RGBA8888>(data, begin, last, alignment, callback); break;
+		case LitColor::RGBF: ForEachMatch<LitColor::RGBF>(data, begin, last, alignment, callback); break;
+		case LitColor::RGBAF: ForEachMatch<LitColor::RGBAF>(data, begin, last, alignment, callback); break;
+		case LitColor::RGBA16F: ForEachMatch<LitColor::RGBA16F>(data, begin, last, alignment, callback); break;
+		case LitColor::RGB5A3: ForEachMatch<LitColor::RGB5A3>(data, begin, last, alignment, callback); break;
+		default: ForEachMatch<LitColor::RGB565>(data, begin, last, alignment, callback);
+		}
+	}
+};
+
+class LitColorCrossFormatQuery
+{
+public:
+	enum Formats
+	{
+		FORMAT_RGB888 = 1 << LitColor::RGB888,
+		FORMAT_RGBA8888 = 1 << LitColor::RGBA8888,
+		FORMAT_RGBF = 1 << LitColor::RGBF,
+		FORMAT_RGBAF = 1 << LitColor::RGBAF,
+		FORMAT_RGB565 = 1 << LitColor::RGB565,
+		FORMAT_RGB5A3 = 1 << LitColor::RGB5A3,
+		FORMAT_RGBA16F = 1 << LitColor::RGBA16F,
+		FORMAT_ALL = FORMAT_RGB888 | FORMAT_RGBA8888 | FORMAT_RGBF | FORMAT_RGBAF | FORMAT_RGB565 | FORMAT_RGB5A3 | FORMAT_RGBA16F
+	};
+
+private:
+	struct Code
+	{
+		uint16_t Key;
+		uint16_t Mask;
+	};
+
+	LitColor _target;
+	int _formats = FORMAT_ALL;
+	bool _bigEndian = true;
+	LitColorQuery _rgb888;
+	LitColorQuery _rgba8888;
+	LitColorQuery _rgbf;
+	LitColorQuery _rgbaf;
+	LitColorQuery _rgba16f;
+	Code _rgb565Codes[2] = {};
+	Code _rgb5A3Codes[4] = {};
+	int _rgb565CodeCount = 0;
+	int _rgb5A3CodeCount = 0;
+
+	static uint32_t quantizeTruncated(const int32_t val, const int bits)
+	{
+		return static_cast<uint32_t>(val) >> (8 - bits);
+	}
+
+	static uint32_t quantizeRounded(const int32_t val, const int bits)
+	{
+		const uint32_t max = (1u << bits) - 1;
+		return (static_cast<uint32_t>(val) * max + 127) / 255;
+	}
+
+	static void addCode(Code* codes, int& count, const uint16_t key, const uint16_t mask)
+	{
+		for (int i = 0; i < count; ++i)
+			if (codes[i].Key == (key & mask) && codes[i].Mask == mask)
+				return;
+
+		codes[count++] = { static_cast<uint16_t>(key & mask), mask };
+	}
+
+	template<int Type> bool matchesCode(const uint8_t* ptr, const Code* codes, const int count) const
+	{
+		uint32_t word;
+		_rgb888.LoadWord<Type>(ptr, word);
+
+		for (int i = 0; i < count; ++i)
+			if ((word & codes[i].Mask) == codes[i].Key)
+				return true;
+
+		return false;
+	}
+
+public:
+	LitColorCrossFormatQuery(LitColor target, const int formats = FORMAT_ALL, const bool bigEndian = true)
+		: _target(target), _formats(formats), _bigEndian(bigEndian),
+		_rgb888(target, LitColor::RGB888, LitColorQuery::EXACT, bigEndian),
+		_rgba8888(target, LitColor::RGBA8888, LitColorQuery::EXACT, bigEndian),
+		_rgbf(target, LitColor::RGBF, LitColorQuery::EXACT, bigEndian),
+		_rgbaf(target, LitColor::RGBAF, LitColorQuery::EXACT, bigEndian),
+		_rgba16f(target, LitColor::RGBA16F, LitColorQuery::EXACT, bigEndian)
+	{
+		const int32_t r = target.GetColorValue<int32_t>(LitColor::RED);
+		const int32_t g = target.GetColorValue<int32_t>(LitColor::GREEN);
+		const int32_t b = target.GetColorValue<int32_t>(LitColor::BLUE);
+		const int32_t a = target.GetColorValue<int32_t>(LitColor::ALPHA);
+
+		//LitColor truncates when quantizing, most encoders round. Both codes count as the same color
+		for (auto quantize : { quantizeTruncated, quantizeRounded })
+		{
+			addCode(_rgb565Codes, _rgb565CodeCount, static_cast<uint16_t>(quantize(r, 5) << 11 | quantize(g, 6) << 5 | quantize(b, 5)), 0xFFFF);
+			addCode(_rgb5A3Codes, _rgb5A3CodeCount, static_cast<uint16_t>(0x8000 | quantize(r, 5) << 10 | quantize(g, 5) << 5 | quantize(b, 5)), 0xFFFF);
+			addCode(_rgb5A3Codes, _rgb5A3CodeCount, static_cast<uint16_t>(quantize(a, 3) << 12 | quantize(r, 4) << 8 | quantize(g, 4) << 4 | quantize(b, 4)), target.UsesAlpha() ? 0xFFFF : 0x8FFF);
+		}
+	}
+
+	int GetFormats() const
+	{
+		return _formats;
+	}
+
+	const LitColor& GetTarget() const
+	{
+		return _target;
+	}
+
+	bool IsBigEndian() const
+	{
+		return _bigEndian;
+	}
+
+	static size_t GetMaxValueSize()
+	{
+		return 16;
+	}
+
+	//calls callback(offset, type) for every format matching at an offset in [begin, end). Values must end before size
+	template<typename Callback> void ForEachMatch(const uint8_t* data, const size_t size, const size_t begin, const size_t end, const uint32_t alignment, Callback callback) const
+	{
+		const int formats = _formats;
+
+		for (size_t offset = begin; offset < end && offset + 2 <= size; offset += alignment)
+		{
+			const uint8_t* ptr = data + offset;
+			const size_t remaining = size - offset;
+
+			if ((formats & FORMAT_RGB565) && matchesCode<LitColor::RGB565>(ptr, _rgb565Codes, _rgb565CodeCount))
+				callback(offset, LitColor::RGB565);
+
+			if ((formats & FORMAT_RGB5A3) && matchesCode<LitColor::RGB5A3>(ptr, _rgb5A3Codes, _rgb5A3CodeCount))
+				callback(offset, LitColor::RGB5A3);
+
+			if (remaining < 3)
+				continue;
+
+			if ((formats & FORMAT_RGB888) && _rgb888.Matches<LitColor::RGB888>(ptr))
+				callback(offset, LitColor::RGB888);
+
+			if (remaining < 4)
+				continue;
+
+			if ((formats & FORMAT_RGBA8888) && _rgba8888.Matches<LitColor::RGBA8888>(ptr))
+				callback(offset, LitColor::RGBA8888);
+
+			if (remaining < 8)
+				continue;
+
+			if ((formats & FORMAT_RGBA16F) && _rgba16f.Matches<LitColor::RGBA16F>(ptr))
+				callback(offset, LitColor::RGBA16F);
+
+			if (remaining < 12)
+				continue;
+
+			if ((formats & FORMAT_RGBF) && _rgbf.Matches<LitColor::RGBF>(ptr))
+				callback(offset, LitColor::RGBF);
+
+			if (remaining >= 16 && (formats & FORMAT_RGBAF) && _rgbaf.Matches<LitColor::RGBAF>(ptr))
+				callback(offset, LitColor::RGBAF);
+		}
+	}
+};
@@ -0,0 +1,351 @@
+﻿#pragma once
+
+#include <array>
+#include <optional>
+#include "LitColorArena.h"
+#include "LitColorScanner.h"
+
+#ifdef __linux__
+#include "LitColorProcess.h"
+#endif
+
+//hits stored in the arena of a LitColorScanSession, sorted by address. Valid until the session is reset
+struct LitColorHitSpan
+{
+	const LitColorHit* Hits = nullptr;
+	size_t Count = 0;
+
+	const LitColorHit* begin() const
+	{
+		return Hits;
+	}
+
+	const LitColorHit* end() const
+	{
+		return Hits + Count;
+	}
+
+	size_t GetSize() const
+	{
+		return Count;
+	}
+
+	const LitColorHit& operator[](const size_t index) const
+	{
+		return Hits[index];
+	}
+};
+
+//owns the memory of a series of scans and refinements. Hits live in an arena, reads go through reused huge page buffers
+class LitColorScanSession
+{
+private:
+	struct Piece
+	{
+		uint64_t Address;
+		size_t Size;
+		size_t BufferOffset;
+		size_t FirstHit;
+		size_t HitCount;
+	};
+
+	static constexpr uint64_t PIECE_GAP = 64;
+
+	LitColorArena _arena;
+	size_t _bufferSize = 0x2000000;
+	unsigned int _threadCount = 0;
+	std::vector<std::unique_ptr<LitColorPageBuffer>> _buffers;
+	std::vector<LitColorPageBuffer*> _freeBuffers;
+	std::vector<std::vector<LitColorHit>> _threadHits;
+	std::vector<Piece> _pieces;
+	std::mutex _mutex;
+
+#ifdef __linux__
+	std::vector<iovec> _localIovs;
+	std::vector<iovec> _remoteIovs;
+#endif
+
+	LitColorHitSpan store(const std::vector<LitColorHit>* parts, const size_t partCount)
+	{
+		size_t count = 0;
+
+		for (size_t i = 0; i < partCount; ++i)
+			count += parts[i].size();
+
+		LitColorHit* hits = _arena.Allocate<LitColorHit>(count);
+		LitColorHit* out = hits;
+
+		for (size_t i = 0; i < partCount; ++i)
+			out = std::copy(parts[i].begin(), parts[i].end(), out);
+
+		return { hits, count };
+	}
+
+	//hits whose value matches are kept, in order. The result reuses the space of a single allocation
+	template<typename Reader, typename Matcher> LitColorHitSpan refine(const LitColorHitSpan& hits, Reader reader, Matcher matcher)
+	{
+		LitColorHit* refined = _arena.Allocate<LitColorHit>(hits.Count);
+		size_t count = 0;
+
+		reader([&](const size_t index, const uint8_t* value)
+		{
+			if (value && matcher(value, hits[index].Type))
+				refined[count++] = hits[index];
+		});
+
+		_arena.Shrink(refined, count * sizeof(LitColorHit));
+		return { refined, count };
+	}
+
+	static auto exactMatcher(const LitColor& target, const bool bigEndian)
+	{
+		return [queries = std::array<std::optional<LitColorQuery>, LitColor::RGBA16F + 1>(), target, bigEndian](const uint8_t* value, const int type) mutable
+		{
+			if (type < 0 || type > LitColor::RGBA16F)
+				return false;
+
+			if (!queries[type])
+				queries[type].emplace(target, type, LitColorQuery::EXACT, bigEndian);
+
+			return queries[type]->Matches(value);
+		};
+	}
+
+	static auto queryMatcher(const LitColorQuery& query)
+	{
+		return [&query](const uint8_t* value, const int type) { return type == query.GetType() && query.Matches(value); };
+	}
+
+	static auto dumpReader(const LitColorHitSpan& hits, const uint8_t* data, const size_t size, const uint64_t baseAddress)
+	{
+		return [&hits, data, size, baseAddress](auto callback)
+		{
+			for (size_t i = 0; i < hits.Count; ++i)
+			{
+				const uint64_t address = hits[i].Address;
+				const bool inside = address >= baseAddress && address - baseAddress + LitColorScanner::GetTypeSize(hits[i].Type) <= size;
+				callback(i, inside ? data + (address - baseAddress) : nullptr);
+			}
+		};
+	}
+
+#ifdef __linux__
+	bool readPieces(const pid_t pid, LitColorPageBuffer& buffer)
+	{
+		_localIovs.clear();
+		_remoteIovs.clear();
+
+		for (const auto& piece : _pieces)
+		{
+			_localIovs.push_back({ buffer.GetData() + piece.BufferOffset, piece.Size });
+			_remoteIovs.push_back({ reinterpret_cast<void*>(piece.Address), piece.Size });
+		}
+
+		const ssize_t expected = static_cast<ssize_t>(_pieces.back().BufferOffset + _pieces.back().Size);
+
+		if (process_vm_readv(pid, _localIovs.data(), _localIovs.size(), _remoteIovs.data(), _remoteIovs.size(), 0) == expected)
+			return true;
+
+		//pieces that fail on their own are marked by a size of 0
+		for (size_t i = 0; i < _pieces.size(); ++i)
+			if (process_vm_readv(pid, &_localIovs[i], 1, &_remoteIovs[i], 1, 0) != static_cast<ssize_t>(_pieces[i].Size))
+				_pieces[i].Size = 0;
+
+		return false;
+	}
+
+	//reads the values of neighbouring hits as one piece, as many pieces per call as the buffer and IOV_MAX allow
+	auto processReader(const LitColorHitSpan& hits, const pid_t pid)
+	{
+		return [this, &hits, pid](auto callback)
+		{
+			LitColorPageBuffer& buffer = *AcquireBuffer();
+			size_t used = 0;
+
+			auto flush = [&]()
+			{
+				if (_pieces.empty())
+					return;
+
+				readPieces(pid, buffer);
+
+				for (const auto& piece : _pieces)
+					for (size_t i = piece.FirstHit; i < piece.FirstHit + piece.HitCount; ++i)
+						callback(i, piece.Size ? buffer.GetData() + piece.BufferOffset + (hits[i].Address - piece.Address) : nullptr);
+
+				_pieces.clear();
+				used = 0;
+			};
+
+			for (size_t i = 0; i < hits.Count; ++i)
+			{
+				const uint64_t address = hits[i].Address;
+				const uint64_t end = address + LitColorScanner::GetTypeSize(hits[i].Type);
+
+				if (!_pieces.empty() && address <= _pieces.back().Address + _pieces.back().Size + PIECE_GAP && used - _pieces.back().Size + (end - _pieces.back().Address) <= buffer.GetSize())
+				{
+					Piece& piece = _pieces.back();
+					const size_t size = static_cast<size_t>(std::max<uint64_t>(end - piece.Address, piece.Size));
+					used += size - piece.Size;
+					piece.Size = size;
+					++piece.HitCount;
+					continue;
+				}
+
+				if (used + (end - address) > buffer.GetSize() || _pieces.size() >= IOV_MAX)
+					flush();
+
+				_pieces.push_back({ address, static_cast<size_t>(end - address), used, i, 1 });
+				used += static_cast<size_t>(end - address);
+			}
+
+			flush();
+			ReleaseBuffer(&buffer);
+		};
+	}
+#endif
+
+public:
+	//bufferSize is the size of each I/O buffer, arenaBlockSize the granularity the arena grows by
+	LitColorScanSession(const size_t bufferSize = 0x2000000, const size_t arenaBlockSize = 0x4000000, const unsigned int threadCount = 0)
+		: _arena(arenaBlockSize), _bufferSize(bufferSize), _threadCount(threadCount)
+	{
+		if (_threadCount == 0)
+			_threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		_threadHits.resize(_threadCount);
+	}
+
+	LitColorScanSession(const LitColorScanSession&) = delete;
+	LitColorScanSession& operator=(const LitColorScanSession&) = delete;
+
+	//buffers are created on demand and kept for the whole session
+	LitColorPageBuffer* AcquireBuffer()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (_freeBuffers.empty())
+		{
+			_buffers.push_back(std::make_unique<LitColorPageBuffer>(_bufferSize));
+			return _buffers.back().get();
+		}
+
+		LitColorPageBuffer* buffer = _freeBuffers.back();
+		_freeBuffers.pop_back();
+		return buffer;
+	}
+
+	void ReleaseBuffer(LitColorPageBuffer* buffer)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_freeBuffers.push_back(buffer);
+	}
+
+	//splits data into one contiguous range per thread, so the concatenated hits are sorted without sorting
+	LitColorHitSpan Scan(const LitColorScanner& scanner, const uint8_t* data, const size_t size, const uint64_t baseAddress = 0)
+	{
+		const size_t alignment = scanner.GetAlignment();
+		const size_t share = (size / _threadCount + alignment - 1) / alignment * alignment;
+		std::vector<std::thread> workers;
+
+		for (unsigned int i = 0; i < _threadCount; ++i)
+		{
+			_threadHits[i].clear();
+			const size_t begin = std::min(share * i, size);
+			const size_t end = i + 1 == _threadCount ? size : std::min(begin + share, size);
+
+			if (begin < end)
+				workers.emplace_back([&, i, begin, end]() { scanner.ScanRange(data, size, begin, end, baseAddress, _threadHits[i]); });
+		}
+
+		for (auto& thread : workers)
+			thread.join();
+
+		return store(_threadHits.data(), _threadHits.size());
+	}
+
+	//keeps the hits whose value at their own type equals target
+	LitColorHitSpan Refine(const LitColorHitSpan& hits, const LitColor& target, const uint8_t* data, const size_t size, const uint64_t baseAddress = 0, const bool bigEndian = true)
+	{
+		return refine(hits, dumpReader(hits, data, size, baseAddress), exactMatcher(target, bigEndian));
+	}
+
+	//keeps the hits of the query's type that match it
+	LitColorHitSpan Refine(const LitColorHitSpan& hits, const LitColorQuery& query, const uint8_t* data, const size_t size, const uint64_t baseAddress = 0)
+	{
+		return refine(hits, dumpReader(hits, data, size, baseAddress), queryMatcher(query));
+	}
+
+#ifdef __linux__
+	//process reads into one of the session's buffers
+	LitColorHitSpan Scan(LitColorProcess& process, const LitColorScanner& scanner, const std::vector<LitColorMemoryRegion>& regions, std::shared_ptr<LitColorScanProgress> progress = nullptr)
+	{
+		LitColorPageBuffer* buffer = AcquireBuffer();
+		std::vector<LitColorHit>& hits = _threadHits.front();
+		hits.clear();
+		process.SetBuffer(buffer->GetData(), buffer->GetSize());
+		process.Scan(scanner, regions, hits, progress);
+		process.SetBuffer(nullptr, 0);
+		ReleaseBuffer(buffer);
+		return store(&hits, 1);
+	}
+
+	LitColorHitSpan Scan(LitColorProcess& process, const LitColorScanner& scanner, std::shared_ptr<LitColorScanProgress> progress = nullptr)
+	{
+		return Scan(process, scanner, process.GetRegions(true), progress);
+	}
+
+	LitColorHitSpan Refine(const LitColorHitSpan& hits, const LitColor& target, const pid_t pid, const bool bigEndian = true)
+	{
+		return refine(hits, processReader(hits, pid), exactMatcher(target, bigEndian));
+	}
+
+	LitColorHitSpan Refine(const LitColorHitSpan& hits, const LitColorQuery& query, const pid_t pid)
+	{
+		return refine(hits, processReader(hits, pid), queryMatcher(query));
+	}
+#endif
+
+	//copies hits into the arena, e.g. results of LitColorScanner::ScanAsync()
+	LitColorHitSpan Store(const std::vector<LitColorHit>& hits)
+	{
+		return store(&hits, 1);
+	}
+
+	//everything allocated after marker is released, older spans stay valid
+	LitColorArena::Marker GetMarker() const
+	{
+		return _arena.GetMarker();
+	}
+
+	void Rewind(const LitColorArena::Marker& marker)
+	{
+		_arena.Rewind(marker);
+	}
+
+	//invalidates all spans in O(1). Arena blocks and buffers are kept for the next scans
+	void Reset()
+	{
+		_arena.Reset();
+	}
+
+	LitColorArena& GetArena()
+	{
+		return _arena;
+	}
+
+	size_t GetUsedBytes() const
+	{
+		return _arena.GetUsedBytes();
+	}
+
+	size_t GetReservedBytes() const
+	{
+		size_t reserved = _arena.GetReservedBytes();
+
+		for (const auto& buffer : _buffers)
+			reserved += buffer->GetSize();
+
+		return reserved;
+	}
+};
@@ -0,0 +1,460 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "LitColorQuery.h"
+#include "LitColorSpaceQuery.h"
+#include "LitColorThreadPool.h"
+
+struct LitColorHit
+{
+	uint64_t Address = 0;
+	int Type = LitColor::RGBA8888;
+
+	bool operator<(const LitColorHit& other) const
+	{
+		return Address < other.Address;
+	}
+};
+
+class LitColorScanProgress
+{
+private:
+	std::atomic<uint64_t> _bytesProcessed = 0;
+	std::atomic<uint64_t> _bytesTotal = 0;
+	std::atomic<bool> _cancelRequested = false;
+	std::atomic<bool> _finished = false;
+
+public:
+	//called by every scan on start, so a progress object can be reused after a cancelled scan
+	void Reset(const uint64_t bytesTotal)
+	{
+		_bytesProcessed = 0;
+		_bytesTotal = bytesTotal;
+		_cancelRequested = false;
+		_finished = false;
+	}
+
+	void Cancel()
+	{
+		_cancelRequested = true;
+	}
+
+	bool IsCancelled() const
+	{
+		return _cancelRequested;
+	}
+
+	void AddBytesProcessed(const uint64_t bytes)
+	{
+		_bytesProcessed += bytes;
+	}
+
+	uint64_t GetBytesProcessed() const
+	{
+		return _bytesProcessed;
+	}
+
+	uint64_t GetBytesTotal() const
+	{
+		return _bytesTotal;
+	}
+
+	float GetPercentage() const
+	{
+		const uint64_t total = _bytesTotal;
+
+		if (total == 0)
+			return _finished ? 100.0f : 0.0f;
+
+		return static_cast<float>(static_cast<double>(_bytesProcessed) * 100.0 / static_cast<double>(total));
+	}
+
+	void SetFinished()
+	{
+		_finished = true;
+	}
+
+	bool IsFinished() const
+	{
+		return _finished;
+	}
+};
+
+class LitColorScanner
+{
+private:
+	LitColor _target;
+	LitColorQuery _query;
+	std::optional<LitColorCrossFormatQuery> _crossFormatQuery;
+	std::optional<LitColorSpaceQuery> _spaceQuery;
+	int _type = LitColor::RGBA8888;
+	bool _bigEndian = true;
+	uint32_t _alignment = 4;
+	size_t _chunkSize = 0x100000;
+	bool _exactTarget = false;
+
+	static bool isHostBigEndian()
+	{
+		const uint16_t probe = 1;
+		return *reinterpret_cast<const uint8_t*>(&probe) == 0;
+	}
+
+	//state of one ScanAsync() call, shared by its pool tasks. The last task to finish fulfills the promise
+	struct asyncScan
+	{
+		std::shared_ptr<const LitColorScanner> Scanner; //a copy, the scanner itself may go away during the scan
+		const uint8_t* Data;
+		size_t Size;
+		uint64_t BaseAddress;
+		std::shared_ptr<LitColorScanProgress> Progress;
+		std::function<void(const std::vector<LitColorHit>&)> OnPartialResults;
+		size_t ChunkCount = 0;
+		std::atomic<size_t> NextChunk = 0;
+		std::atomic<unsigned int> RemainingWorkers = 0;
+		std::mutex ResultMutex;
+		std::vector<LitColorHit> Results;
+		std::exception_ptr Error;
+		std::promise<std::vector<LitColorHit>> Promise;
+
+		asyncScan(std::shared_ptr<const LitColorScanner> scanner, const uint8_t* data, const size_t size, const uint64_t baseAddress,
+			std::shared_ptr<LitColorScanProgress> progress, std::function<void(const std::vector<LitColorHit>&)> onPartialResults)
+			: Scanner(std::move(scanner)), Data(data), Size(size), BaseAddress(baseAddress), Progress(std::move(progress)), OnPartialResults(std::move(onPartialResults))
+		{}
+
+		void Work()
+		{
+			const size_t chunkSize = Scanner->GetChunkSize();
+			std::vector<LitColorHit> hits;
+
+			try
+			{
+				for (size_t chunk = NextChunk++; chunk < ChunkCount; chunk = NextChunk++)
+				{
+					if (Progress->IsCancelled())
+						break;
+
+					const size_t begin = chunk * chunkSize;
+					const size_t end = std::min(begin + chunkSize, Size);
+					hits.clear();
+					Scanner->ScanRange(Data, Size, begin, end, BaseAddress, hits);
+
+					{
+						std::lock_guard<std::mutex> lock(ResultMutex);
+						Results.insert(Results.end(), hits.begin(), hits.end());
+
+						if (OnPartialResults && !hits.empty())
+							OnPartialResults(hits);
+					}
+
+					Progress->AddBytesProcessed(end - begin);
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(ResultMutex);
+
+				if (!Error)
+					Error = std::current_exception();
+
+				//the other tasks stop at their next chunk
+				NextChunk = ChunkCount;
+			}
+
+			if (--RemainingWorkers != 0)
+				return;
+
+			Progress->SetFinished();
+
+			if (Error)
+				Promise.set_exception(Error);
+			else
+			{
+				std::sort(Results.begin(), Results.end());
+				Promise.set_value(std::move(Results));
+			}
+		}
+	};
+
+public:
+	LitColorScanner(const LitColor& target, const int type, const bool bigEndian = true, const uint32_t alignment = 4)
+		: _target(target), _query(target, type, LitColorQuery::EXACT, bigEndian), _type(type), _bigEndian(bigEndian), _alignment(alignment ? alignment : 1)
+	{
+		_target.SelectType(type, target.UsesAlpha());
+		_query = LitColorQuery(_target, type, LitColorQuery::EXACT, bigEndian);
+		_exactTarget = true;
+	}
+
+	LitColorScanner(const LitColorQuery& query, const uint32_t alignment = 4)
+		: _query(query), _type(query.GetType()), _bigEndian(query.IsBigEndian()), _alignment(alignment ? alignment : 1)
+	{}
+
+	LitColorScanner(const LitColorCrossFormatQuery& query, const uint32_t alignment = 2)
+		: _target(query.GetTarget()), _query(query.GetTarget(), LitColor::RGBA8888, LitColorQuery::EXACT, query.IsBigEndian()), _crossFormatQuery(query),
+		_type(ANY_TYPE), _bigEndian(query.IsBigEndian()), _alignment(alignment ? alignment : 1)
+	{}
+
+	//hits are of the query's type, see LitColorSpaceQuery::GetType()
+	LitColorScanner(const LitColorSpaceQuery& query, const uint32_t alignment = 1)
+		: _target(query.GetTarget()), _query(query.GetTarget(), LitColor::RGBA8888, LitColorQuery::EXACT, query.IsBigEndian()), _spaceQuery(query),
+		_type(query.GetType()), _bigEndian(query.IsBigEndian()), _alignment(alignment ? alignment : 1)
+	{}
+
+	static constexpr int ANY_TYPE = -1;
+
+	static size_t GetTypeSize(const int type)
+	{
+		if (LitColorSpaceQuery::IsSpaceType(type))
+			return LitColorSpaceQuery::GetTypeSize(type);
+
+		switch (type)
+		{
+		case LitColor::RGB888: return 3;
+		case LitColor::RGBA8888: return 4;
+		case LitColor::RGBF: return 12;
+		case LitColor::RGBAF: return 16;
+		case LitColor::RGBA16F: return 8;
+		default: return 2; //RGB565, RGB5A3
+		}
+	}
+
+	static uint16_t SwapBytes(const uint16_t val)
+	{
+		return static_cast<uint16_t>((val >> 8) | (val << 8));
+	}
+
+	static uint32_t SwapBytes(const uint32_t val)
+	{
+		return (val >> 24) | ((val >> 8) & 0xFF00) | ((val << 8) & 0xFF0000) | (val << 24);
+	}
+
+	template<typename T> static T ReadValue(const uint8_t* ptr, const bool bigEndian)
+	{
+		T val;
+		std::memcpy(&val, ptr, sizeof(T));
+
+		if (bigEndian == isHostBigEndian())
+			return val;
+
+		if constexpr (std::is_floating_point_v<T>)
+		{
+			uint32_t raw;
+			std::memcpy(&raw, &val, sizeof(raw));
+			raw = SwapBytes(raw);
+			std::memcpy(&val, &raw, sizeof(raw));
+			return val;
+		}
+		else
+			return SwapBytes(val);
+	}
+
+	//space types are stored with a hue range that hits don't carry, they decode to the default color
+	static LitColor DecodeAt(const uint8_t* ptr, const int type, const bool bigEndian)
+	{
+		if (LitColorSpaceQuery::IsSpaceType(type))
+			return LitColor();
+
+		switch (type)
+		{
+		case LitColor::RGB888:
+			return LitColor(static_cast<uint32_t>(ptr[0]) << 24 | static_cast<uint32_t>(ptr[1]) << 16 | static_cast<uint32_t>(ptr[2]) << 8 | 0xFF, false);
+		case LitColor::RGBA8888:
+			return LitColor(ReadValue<uint32_t>(ptr, bigEndian));
+		case LitColor::RGBF:
+		case LitColor::RGBAF: {
+			const bool usesAlpha = type == LitColor::RGBAF;
+			float channels[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+			for (int i = 0; i < (usesAlpha ? 4 : 3); ++i)
+				channels[i] = ReadValue<float>(ptr + i * sizeof(float), bigEndian);
+
+			return LitColor(channels, usesAlpha);
+		}
+		case LitColor::RGBA16F: {
+			float channels[4];
+
+			for (int i = 0; i < 4; ++i)
+				channels[i] = LitColor::HalfToFloat(ReadValue<uint16_t>(ptr + i * sizeof(uint16_t), bigEndian));
+
+			LitColor color(channels, true);
+			color.SelectType(LitColor::RGBA16F);
+			return color;
+		}
+		case LitColor::RGB5A3:
+			return LitColor(ReadValue<uint16_t>(ptr, bigEndian), LitColor::RGB5A3);
+		default: //RGB565
+			return LitColor(ReadValue<uint16_t>(ptr, bigEndian), LitColor::RGB565);
+		}
+	}
+
+	template<typename T> static void WriteValue(uint8_t* ptr, T val, const bool bigEndian)
+	{
+		if (bigEndian != isHostBigEndian())
+		{
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				uint32_t raw;
+				std::memcpy(&raw, &val, sizeof(raw));
+				raw = SwapBytes(raw);
+				std::memcpy(&val, &raw, sizeof(raw));
+			}
+			else
+				val = SwapBytes(val);
+		}
+
+		std::memcpy(ptr, &val, sizeof(T));
+	}
+
+	//returns false and leaves ptr untouched for space types, see DecodeAt()
+	static bool EncodeAt(uint8_t* ptr, LitColor color, const int type, const bool bigEndian)
+	{
+		if (LitColorSpaceQuery::IsSpaceType(type))
+			return false;
+
+		switch (type)
+		{
+		case LitColor::RGB888: {
+			const uint32_t rgba = color.GetRGBA();
+			ptr[0] = static_cast<uint8_t>(rgba >> 24);
+			ptr[1] = static_cast<uint8_t>(rgba >> 16);
+			ptr[2] = static_cast<uint8_t>(rgba >> 8);
+		} break;
+		case LitColor::RGBA8888:
+			WriteValue<uint32_t>(ptr, color.GetRGBA(), bigEndian);
+			break;
+		case LitColor::RGBF:
+		case LitColor::RGBAF: {
+			const int channelCount = type == LitColor::RGBAF ? 4 : 3;
+
+			for (int i = 0; i < channelCount; ++i)
+				WriteValue<float>(ptr + i * sizeof(float), color.GetColorValue<float>(i), bigEndian);
+		} break;
+		case LitColor::RGBA16F:
+			for (int i = 0; i < 4; ++i)
+				WriteValue<uint16_t>(ptr + i * sizeof(uint16_t), LitColor::FloatToHalf(color.GetColorValue<float>(i)), bigEndian);
+			break;
+		case LitColor::RGB5A3:
+			WriteValue<uint16_t>(ptr, color.GetRGB5A3(), bigEndian);
+			break;
+		default: //RGB565
+			WriteValue<uint16_t>(ptr, color.GetRGB565(), bigEndian);
+		}
+
+		return true;
+	}
+
+	void SetChunkSize(const size_t chunkSize)
+	{
+		_chunkSize = std::max<size_t>(chunkSize, _alignment);
+	}
+
+	size_t GetChunkSize() const
+	{
+		return _chunkSize - _chunkSize % _alignment;
+	}
+
+	void ScanRange(const uint8_t* data, const size_t size, const size_t begin, const size_t end, const uint64_t baseAddress, std::vector<LitColorHit>& hits) const
+	{
+		if (_crossFormatQuery)
+		{
+			_crossFormatQuery->ForEachMatch(data, size, begin, end, _alignment, [&](const size_t offset, const int type) { hits.push_back({ baseAddress + offset, type }); });
+			return;
+		}
+
+		const size_t typeSize = GetTypeSize(_type);
+
+		if (size < typeSize)
+			return;
+
+		const size_t last = std::min(end, size - typeSize + 1);
+
+		if (_spaceQuery)
+		{
+			_spaceQuery->ForEachMatch(data, begin, last, _alignment, [&](const size_t offset) { hits.push_back({ baseAddress + offset, _type }); });
+			return;
+		}
+
+		_query.ForEachMatch(data, begin, last, _alignment, [&](const size_t offset) { hits.push_back({ baseAddress + offset, _type }); });
+	}
+
+	int GetType() const
+	{
+		return _type;
+	}
+
+	size_t GetValueSize() const
+	{
+		return _crossFormatQuery ? LitColorCrossFormatQuery::GetMaxValueSize() : GetTypeSize(_type);
+	}
+
+	uint32_t GetAlignment() const
+	{
+		return _alignment;
+	}
+
+	bool IsBigEndian() const
+	{
+		return _bigEndian;
+	}
+
+	const LitColor& GetTarget() const
+	{
+		return _target;
+	}
+
+	const LitColorQuery& GetQuery() const
+	{
+		return _query;
+	}
+
+	//true if the scanner matches one target color exactly, false for query, cross-format and space scans
+	bool IsExactTarget() const
+	{
+		return _exactTarget;
+	}
+
+	std::vector<LitColorHit> Scan(const uint8_t* data, const size_t size, const uint64_t baseAddress = 0) const
+	{
+		std::vector<LitColorHit> hits;
+		ScanRange(data, size, 0, size, baseAddress, hits);
+		return hits;
+	}
+
+	//runs on the shared thread pool, hits are always collected so the future holds them all
+	std::future<std::vector<LitColorHit>> ScanAsync(const uint8_t* data, const size_t size, const uint64_t baseAddress,
+		std::shared_ptr<LitColorScanProgress> progress = nullptr,
+		std::function<void(const std::vector<LitColorHit>&)> onPartialResults = nullptr,
+		unsigned int threadCount = 0) const
+	{
+		if (!progress)
+			progress = std::make_shared<LitColorScanProgress>();
+
+		LitColorThreadPool& pool = LitColorThreadPool::GetShared();
+
+		if (threadCount == 0)
+			threadCount = pool.GetThreadCount();
+
+		progress->Reset(size);
+		auto job = std::make_shared<asyncScan>(std::make_shared<const LitColorScanner>(*this), data, size, baseAddress, progress, std::move(onPartialResults));
+		const size_t chunkCount = (size + GetChunkSize() - 1) / GetChunkSize();
+		const unsigned int workerCount = static_cast<unsigned int>(std::max<size_t>(1, std::min<size_t>({ threadCount, pool.GetThreadCount(), chunkCount })));
+		job->ChunkCount = chunkCount;
+		job->RemainingWorkers = workerCount;
+		std::future<std::vector<LitColorHit>> future = job->Promise.get_future();
+
+		for (unsigned int i = 0; i < workerCount; ++i)
+			pool.Submit([job]() { job->Work(); });
+
+		return future;
+	}
+};
@@ -0,0 +1,487 @@
+﻿#pragma once
+
+#include <fstream>
+#include <string>
+#include "LitColorScanSession.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//scan parameters as stored in a session file
+struct LitColorSessionTarget
+{
+	uint32_t Rgba = 0;
+	int32_t Type = LitColor::RGBA8888;
+	uint32_t Alignment = 4;
+	uint8_t BigEndian = 1;
+	uint8_t UsesAlpha = 1;
+	uint16_t Reserved = 0;
+};
+
+//versioned binary file of scan results. Hits are stored in delta compressed blocks, the header, targets and block index
+//are fixed layout structs, so a mapped file is queried in place without parsing it first
+class LitColorSessionFile
+{
+public:
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint32_t HITS_PER_BLOCK = 4096;
+
+private:
+	static constexpr char MAGIC[8] = { 'L', 'I', 'T', 'C', 'S', 'E', 'S', 'S' };
+	static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+	static constexpr int16_t MIXED_TYPES = -2;
+	static constexpr uint8_t SPACE_TYPE_CODE = 0x80; //per hit types of LitColorSpaceQuery hits in mixed blocks
+	static constexpr uint32_t FLAG_VALUES = 1;
+
+	struct Header
+	{
+		char Magic[8];
+		uint32_t Version;
+		uint32_t HeaderSize;
+		uint32_t ByteOrderMark;
+		uint32_t Flags;
+		uint32_t TargetCount;
+		uint32_t BlockCount;
+		uint64_t HitCount;
+		uint64_t TargetsOffset;
+		uint64_t BlocksOffset;
+		uint64_t FileSize;
+	};
+
+	struct Block
+	{
+		uint64_t FirstAddress;
+		uint64_t LastAddress;
+		uint64_t Offset;
+		uint32_t Size;
+		uint32_t Count;
+		int16_t Type;
+		uint8_t Shift;
+		uint8_t Reserved[5];
+	};
+
+	static_assert(sizeof(LitColorSessionTarget) == 16 && sizeof(Header) == 64 && sizeof(Block) == 40, "on disk layout");
+
+	const uint8_t* _data = nullptr;
+	size_t _size = 0;
+	std::vector<uint8_t> _fallback;
+	const Header* _header = nullptr;
+	const LitColorSessionTarget* _targets = nullptr;
+	const Block* _blocks = nullptr;
+
+	static void putVarint(std::vector<uint8_t>& out, uint64_t val)
+	{
+		while (val >= 0x80)
+		{
+			out.push_back(static_cast<uint8_t>(val | 0x80));
+			val >>= 7;
+		}
+
+		out.push_back(static_cast<uint8_t>(val));
+	}
+
+	static bool getVarint(const uint8_t*& ptr, const uint8_t* end, uint64_t& val)
+	{
+		val = 0;
+
+		for (int shift = 0; ptr < end && shift < 64; shift += 7)
+		{
+			const uint8_t byte = *ptr++;
+			val |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+			if (!(byte & 0x80))
+				return true;
+		}
+
+		return false;
+	}
+
+	static bool isHostLittleEndian()
+	{
+		const uint16_t probe = 1;
+		return *reinterpret_cast<const uint8_t*>(&probe) == 1;
+	}
+
+	//addresses are stored as deltas divided by their common power of two, types only if they differ within a block
+	static void encodeBlock(const LitColorHit* hits, const size_t count, const uint8_t* data, const size_t size, const uint64_t baseAddress, Block& block, std::vector<uint8_t>& out)
+	{
+		uint64_t deltaBits = 0;
+		block.Type = static_cast<int16_t>(hits[0].Type);
+
+		for (size_t i = 1; i < count; ++i)
+		{
+			deltaBits |= hits[i].Address - hits[i - 1].Address;
+
+			if (hits[i].Type != hits[0].Type)
+				block.Type = MIXED_TYPES;
+		}
+
+		block.Shift = 0;
+
+		while (deltaBits && block.Shift < 63 && !(deltaBits & (1ull << block.Shift)))
+			++block.Shift;
+
+		block.FirstAddress = hits[0].Address;
+		block.LastAddress = hits[count - 1].Address;
+		block.Count = static_cast<uint32_t>(count);
+
+		for (size_t i = 1; i < count; ++i)
+			putVarint(out, (hits[i].Address - hits[i - 1].Address) >> block.Shift);
+
+		if (block.Type == MIXED_TYPES)
+			for (size_t i = 0; i < count; ++i)
+				out.push_back(LitColorSpaceQuery::IsSpaceType(hits[i].Type) ? static_cast<uint8_t>(SPACE_TYPE_CODE | (hits[i].Type - LitColorSpaceQuery::TYPE_BASE)) : static_cast<uint8_t>(hits[i].Type));
+
+		if (!data)
+			return;
+
+		//the value each hit had when the session was saved
+		for (size_t i = 0; i < count; ++i)
+		{
+			const size_t valueSize = LitColorScanner::GetTypeSize(hits[i].Type);
+			const uint64_t address = hits[i].Address;
+
+			if (address >= baseAddress && address - baseAddress + valueSize <= size)
+				out.insert(out.end(), data + (address - baseAddress), data + (address - baseAddress) + valueSize);
+			else
+				out.insert(out.end(), valueSize, 0);
+		}
+	}
+
+	static bool isValidType(const int type)
+	{
+		return (type >= LitColor::RGB888 && type <= LitColor::RGBA16F) || LitColorSpaceQuery::IsSpaceType(type);
+	}
+
+	//without adding, so offsets near the top of the range cannot wrap around
+	bool isInFile(const uint64_t offset, const uint64_t size) const
+	{
+		return offset <= _size && size <= _size - offset;
+	}
+
+	bool validate()
+	{
+		if (_size < sizeof(Header))
+			return false;
+
+		_header = reinterpret_cast<const Header*>(_data);
+
+		if (std::memcmp(_header->Magic, MAGIC, sizeof(MAGIC)) != 0 || _header->ByteOrderMark != BYTE_ORDER_MARK || _header->Version > VERSION
+			|| _header->HeaderSize < sizeof(Header) || _header->FileSize != _size)
+			return false;
+
+		if (_header->TargetsOffset % 8 || _header->BlocksOffset % 8
+			|| !isInFile(_header->TargetsOffset, static_cast<uint64_t>(_header->TargetCount) * sizeof(LitColorSessionTarget))
+			|| !isInFile(_header->BlocksOffset, static_cast<uint64_t>(_header->BlockCount) * sizeof(Block)))
+			return false;
+
+		_targets = reinterpret_cast<const LitColorSessionTarget*>(_data + _header->TargetsOffset);
+		_blocks = reinterpret_cast<const Block*>(_data + _header->BlocksOffset);
+		uint64_t hitCount = 0;
+
+		for (uint32_t i = 0; i < _header->BlockCount; ++i)
+		{
+			if (!isInFile(_blocks[i].Offset, _blocks[i].Size) || _blocks[i].Count == 0 || _blocks[i].Count > HITS_PER_BLOCK)
+				return false;
+
+			//deltas are shifted by Shift while decoding
+			if (_blocks[i].Shift >= 64 || (_blocks[i].Type != MIXED_TYPES && !isValidType(_blocks[i].Type)))
+				return false;
+
+			//queries binary search the index
+			if (_blocks[i].FirstAddress > _blocks[i].LastAddress || (i > 0 && _blocks[i - 1].LastAddress > _blocks[i].FirstAddress))
+				return false;
+
+			hitCount += _blocks[i].Count;
+		}
+
+		return hitCount == _header->HitCount;
+	}
+
+public:
+	LitColorSessionFile() {}
+
+	LitColorSessionFile(const std::string& path)
+	{
+		Open(path);
+	}
+
+	LitColorSessionFile(const LitColorSessionFile&) = delete;
+	LitColorSessionFile& operator=(const LitColorSessionFile&) = delete;
+
+	~LitColorSessionFile()
+	{
+		Close();
+	}
+
+	//a target only holds a color and a type, so query, cross-format and space scans are refused rather than stored as exact scans
+	static bool MakeTarget(const LitColorScanner& scanner, LitColorSessionTarget& target)
+	{
+		if (!scanner.IsExactTarget())
+			return false;
+
+		target = LitColorSessionTarget();
+		target.Rgba = scanner.GetTarget().GetRGBA();
+		target.Type = scanner.GetType();
+		target.Alignment = scanner.GetAlignment();
+		target.BigEndian = scanner.IsBigEndian();
+		target.UsesAlpha = scanner.GetTarget().UsesAlpha();
+		return true;
+	}
+
+	//hits must be sorted by address. With data the current value of every hit is stored as well
+	static bool Save(const std::string& path, const std::vector<LitColorSessionTarget>& targets, const LitColorHit* hits, const size_t count,
+		const uint8_t* data = nullptr, const size_t size = 0, const uint64_t baseAddress = 0)
+	{
+		//the file is mapped as is, so it is only written in the byte order every common host reads natively
+		if (!isHostLittleEndian())
+			return false;
+
+		Header header = {};
+		std::memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+		header.Version = VERSION;
+		header.HeaderSize = sizeof(Header);
+		header.ByteOrderMark = BYTE_ORDER_MARK;
+		header.Flags = data ? FLAG_VALUES : 0;
+		header.TargetCount = static_cast<uint32_t>(targets.size());
+		header.BlockCount = static_cast<uint32_t>((count + HITS_PER_BLOCK - 1) / HITS_PER_BLOCK);
+		header.HitCount = count;
+		header.TargetsOffset = sizeof(Header);
+		header.BlocksOffset = header.TargetsOffset + targets.size() * sizeof(LitColorSessionTarget);
+		std::vector<Block> blocks(header.BlockCount);
+		std::vector<uint8_t> payload;
+		const uint64_t payloadOffset = header.BlocksOffset + blocks.size() * sizeof(Block);
+
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			const size_t first = i * HITS_PER_BLOCK;
+			blocks[i] = {};
+			blocks[i].Offset = payloadOffset + payload.size();
+			encodeBlock(hits + first, std::min<size_t>(HITS_PER_BLOCK, count - first), data, size, baseAddress, blocks[i], payload);
+			blocks[i].Size = static_cast<uint32_t>(payloadOffset + payload.size() - blocks[i].Offset);
+		}
+
+		header.FileSize = payloadOffset + payload.size();
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(targets.data()), static_cast<std::streamsize>(targets.size() * sizeof(LitColorSessionTarget)));
+		file.write(reinterpret_cast<const char*>(blocks.data()), static_cast<std::streamsize>(blocks.size() * sizeof(Block)));
+		file.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+		return static_cast<bool>(file);
+	}
+
+	static bool Save(const std::string& path, const std::vector<LitColorSessionTarget>& targets, const std::vector<LitColorHit>& hits,
+		const uint8_t* data = nullptr, const size_t size = 0, const uint64_t baseAddress = 0)
+	{
+		return Save(path, targets, hits.data(), hits.size(), data, size, baseAddress);
+	}
+
+	bool Open(const std::string& path)
+	{
+		Close();
+
+#ifdef __linux__
+		const int fd = open(path.c_str(), O_RDONLY);
+
+		if (fd < 0)
+			return false;
+
+		struct stat info;
+
+		if (fstat(fd, &info) == 0 && info.st_size > 0)
+		{
+			void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+
+			if (mapping != MAP_FAILED)
+			{
+				_data = static_cast<const uint8_t*>(mapping);
+				_size = static_cast<size_t>(info.st_size);
+			}
+		}
+
+		close(fd);
+#else
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+		if (file)
+		{
+			_fallback.resize(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(reinterpret_cast<char*>(_fallback.data()), static_cast<std::streamsize>(_fallback.size()));
+			_data = _fallback.data();
+			_size = _fallback.size();
+		}
+#endif
+
+		if (_data && validate())
+			return true;
+
+		Close();
+		return false;
+	}
+
+	void Close()
+	{
+#ifdef __linux__
+		if (_data && _fallback.empty())
+			munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+
+		_fallback.clear();
+		_data = nullptr;
+		_size = 0;
+		_header = nullptr;
+		_targets = nullptr;
+		_blocks = nullptr;
+	}
+
+	bool IsOpen() const
+	{
+		return _header != nullptr;
+	}
+
+	uint32_t GetVersion() const
+	{
+		return _header ? _header->Version : 0;
+	}
+
+	bool HasValues() const
+	{
+		return _header && (_header->Flags & FLAG_VALUES);
+	}
+
+	uint64_t GetHitCount() const
+	{
+		return _header ? _header->HitCount : 0;
+	}
+
+	size_t GetTargetCount() const
+	{
+		return _header ? _header->TargetCount : 0;
+	}
+
+	const LitColorSessionTarget& GetTarget(const size_t index) const
+	{
+		return _targets[index];
+	}
+
+	size_t GetBlockCount() const
+	{
+		return _header ? _header->BlockCount : 0;
+	}
+
+	//decodes up to HITS_PER_BLOCK hits. values receives 16 bytes per hit if not nullptr. Returns the number of hits or 0 for a corrupt block
+	size_t DecodeBlock(const size_t index, LitColorHit* hits, uint8_t* values = nullptr) const
+	{
+		const Block& block = _blocks[index];
+		const uint8_t* ptr = _data + block.Offset;
+		const uint8_t* end = ptr + block.Size;
+		hits[0].Address = block.FirstAddress;
+
+		for (uint32_t i = 1; i < block.Count; ++i)
+		{
+			uint64_t delta;
+
+			if (!getVarint(ptr, end, delta))
+				return 0;
+
+			hits[i].Address = hits[i - 1].Address + (delta << block.Shift);
+		}
+
+		for (uint32_t i = 0; i < block.Count; ++i)
+		{
+			if (block.Type != MIXED_TYPES)
+				hits[i].Type = block.Type;
+			else if (ptr < end)
+			{
+				const uint8_t code = *ptr++;
+				hits[i].Type = (code & SPACE_TYPE_CODE) ? LitColorSpaceQuery::TYPE_BASE + (code & ~SPACE_TYPE_CODE) : code;
+
+				if (!isValidType(hits[i].Type))
+					return 0;
+			}
+			else
+				return 0;
+		}
+
+		if (values && HasValues())
+		{
+			for (uint32_t i = 0; i < block.Count; ++i)
+			{
+				const size_t valueSize = LitColorScanner::GetTypeSize(hits[i].Type);
+
+				if (ptr + valueSize > end)
+					return 0;
+
+				std::memcpy(values + i * 16, ptr, valueSize);
+				ptr += valueSize;
+			}
+		}
+
+		return block.Count;
+	}
+
+	//callback(const LitColorHit& hit, const uint8_t* value), value is nullptr if the file holds no values
+	template<typename Callback> void ForEachHit(Callback callback, const uint64_t beginAddress = 0, const uint64_t endAddress = ~0ull) const
+	{
+		if (!_header)
+			return;
+
+		std::vector<LitColorHit> hits(HITS_PER_BLOCK);
+		std::vector<uint8_t> values(HasValues() ? HITS_PER_BLOCK * 16 : 0);
+
+		//the block index is sorted, so only blocks overlapping the range are decoded
+		const Block* first = std::lower_bound(_blocks, _blocks + _header->BlockCount, beginAddress, [](const Block& block, const uint64_t address) { return block.LastAddress < address; });
+
+		for (const Block* block = first; block < _blocks + _header->BlockCount && block->FirstAddress < endAddress; ++block)
+		{
+			const size_t count = DecodeBlock(static_cast<size_t>(block - _blocks), hits.data(), values.empty() ? nullptr : values.data());
+
+			for (size_t i = 0; i < count; ++i)
+				if (hits[i].Address >= beginAddress && hits[i].Address < endAddress)
+					callback(hits[i], values.empty() ? nullptr : values.data() + i * 16);
+		}
+	}
+
+	std::vector<LitColorHit> GetHits(const uint64_t beginAddress = 0, const uint64_t endAddress = ~0ull) const
+	{
+		std::vector<LitColorHit> hits;
+		ForEachHit([&](const LitColorHit& hit, const uint8_t*) { hits.push_back(hit); }, beginAddress, endAddress);
+		return hits;
+	}
+
+	//decodes straight into the arena of a session
+	LitColorHitSpan Load(LitColorScanSession& session) const
+	{
+		LitColorHit* hits = session.GetArena().Allocate<LitColorHit>(static_cast<size_t>(GetHitCount()));
+		size_t count = 0;
+
+		for (size_t i = 0; i < GetBlockCount(); ++i)
+			count += DecodeBlock(i, hits + count);
+
+		return { hits, count };
+	}
+
+	bool Find(const uint64_t address, LitColorHit& hit, uint8_t* value = nullptr) const
+	{
+		bool found = false;
+
+		ForEachHit([&](const LitColorHit& candidate, const uint8_t* candidateValue)
+		{
+			if (found)
+				return;
+
+			hit = candidate;
+			found = true;
+
+			if (value && candidateValue)
+				std::memcpy(value, candidateValue, LitColorScanner::GetTypeSize(candidate.Type));
+		}, address, address + 1);
+
+		return found;
+	}
+};
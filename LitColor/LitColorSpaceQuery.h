@@ -0,0 +1,221 @@
+﻿#pragma once
+
+#include <cmath>
+#include "LitColorConvert.h"
+#include "LitColorQuery.h"
+
+//matches colors stored as HSV, HSL or YCbCr triples. The target is converted once, candidates are compared in their own space
+class LitColorSpaceQuery
+{
+public:
+	enum Spaces
+	{
+		SPACE_HSV,
+		SPACE_HSL,
+		SPACE_YCBCR
+	};
+
+	enum Layouts
+	{
+		LAYOUT_BYTES,
+		LAYOUT_FLOATS
+	};
+
+	//hit types of space scans, beyond the types of LitColor
+	static constexpr int TYPE_BASE = 0x100;
+
+private:
+	LitColor _target;
+	int _space = SPACE_HSV;
+	int _layout = LAYOUT_BYTES;
+	bool _bigEndian = true;
+	float _hueRange = 255.0f;
+	float _key[3] = { 0.0f, 0.0f, 0.0f };
+	float _tolerance[3] = { 1.0f, 1.0f, 1.0f };
+	bool _ignored[3] = { false, false, false };
+	uint8_t _accepted[3][256] = {};
+
+	static bool isHostBigEndian()
+	{
+		const uint16_t probe = 1;
+		return *reinterpret_cast<const uint8_t*>(&probe) == 0;
+	}
+
+	static float loadFloat(const uint8_t* ptr, const bool bigEndian)
+	{
+		uint32_t raw;
+		std::memcpy(&raw, ptr, sizeof(raw));
+
+		if (bigEndian != isHostBigEndian())
+			raw = (raw >> 24) | ((raw >> 8) & 0xFF00) | ((raw << 8) & 0xFF0000) | (raw << 24);
+
+		float val;
+		std::memcpy(&val, &raw, sizeof(val));
+		return val;
+	}
+
+	bool hasHue() const
+	{
+		return _space != SPACE_YCBCR;
+	}
+
+	float channelRange(const int channel) const
+	{
+		if (channel == 0 && hasHue())
+			return _hueRange;
+
+		return _layout == LAYOUT_BYTES ? 255.0f : 1.0f;
+	}
+
+	//distance to the key, around the circle for hue
+	float distance(const int channel, const float val) const
+	{
+		const float delta = std::fabs(val - _key[channel]);
+
+		if (channel == 0 && hasHue())
+			return std::min(delta, _hueRange - delta);
+
+		return delta;
+	}
+
+	//hue bytes of a full turn or more are no hue at all, even when the hue is ignored
+	void compile()
+	{
+		for (int c = 0; c < 3; ++c)
+			for (int val = 0; val < 256; ++val)
+				_accepted[c][val] = (c != 0 || !hasHue() || static_cast<float>(val) < _hueRange) && (_ignored[c] || distance(c, static_cast<float>(val)) <= _tolerance[c] + 0.0001f);
+	}
+
+public:
+	//hueRange is the stored value of a full turn, e.g. 360 for degrees or 180 for OpenCV's 8 bit hue. 0 selects 255 for bytes and 1.0 for floats
+	LitColorSpaceQuery(const LitColor& target, const int space, const int layout = LAYOUT_BYTES, const bool bigEndian = true, const float hueRange = 0.0f)
+		: _target(target), _space(space), _layout(layout), _bigEndian(bigEndian), _hueRange(hueRange > 0.0f ? hueRange : (layout == LAYOUT_BYTES ? 255.0f : 1.0f))
+	{
+		const uint32_t rgba = target.GetRGBA();
+		const float rgb[3] = { static_cast<float>(rgba >> 24) / 255.0f, static_cast<float>((rgba >> 16) & 0xFF) / 255.0f, static_cast<float>((rgba >> 8) & 0xFF) / 255.0f };
+
+		switch (space)
+		{
+		case SPACE_HSL: LitColorConvert::RGBToHSL(rgb, _key, 1); break;
+		case SPACE_YCBCR: LitColorConvert::RGBToYCbCr(rgb, _key, 1); break;
+		default: LitColorConvert::RGBToHSV(rgb, _key, 1);
+		}
+
+		//hue means nothing for grays, neither does saturation for black (HSV) or black and white (HSL)
+		const float lightness = _key[2];
+		_ignored[0] = hasHue() && _key[1] <= 0.0f;
+		_ignored[1] = (space == SPACE_HSV && lightness <= 0.0f) || (space == SPACE_HSL && (lightness <= 0.0f || lightness >= 1.0f));
+		_ignored[0] = _ignored[0] || _ignored[1];
+
+		for (int c = 0; c < 3; ++c)
+		{
+			_key[c] *= channelRange(c);
+			_tolerance[c] = layout == LAYOUT_BYTES ? 1.0f : channelRange(c) / 255.0f;
+
+			if (layout == LAYOUT_BYTES)
+				_key[c] = std::round(_key[c]);
+		}
+
+		if (hasHue() && _key[0] >= _hueRange)
+			_key[0] -= _hueRange;
+
+		compile();
+	}
+
+	//maximum difference per channel in stored units. The default allows for rounding: 1 for bytes, 1/255 of the range for floats
+	void SetTolerance(const float first, const float second, const float third)
+	{
+		_tolerance[0] = first;
+		_tolerance[1] = second;
+		_tolerance[2] = third;
+		compile();
+	}
+
+	static bool IsSpaceType(const int type)
+	{
+		return type >= TYPE_BASE && type < TYPE_BASE + 6;
+	}
+
+	static size_t GetTypeSize(const int type)
+	{
+		return (type - TYPE_BASE) % 2 == LAYOUT_FLOATS ? 3 * sizeof(float) : 3;
+	}
+
+	//type of the hits of a scan with this query
+	int GetType() const
+	{
+		return TYPE_BASE + _space * 2 + _layout;
+	}
+
+	const LitColor& GetTarget() const
+	{
+		return _target;
+	}
+
+	int GetSpace() const
+	{
+		return _space;
+	}
+
+	int GetLayout() const
+	{
+		return _layout;
+	}
+
+	bool IsBigEndian() const
+	{
+		return _bigEndian;
+	}
+
+	size_t GetValueSize() const
+	{
+		return GetTypeSize(GetType());
+	}
+
+	//the target as it would be stored, before tolerance
+	void GetKey(float* key) const
+	{
+		std::copy(_key, _key + 3, key);
+	}
+
+	bool Matches(const uint8_t* ptr) const
+	{
+		if (_layout == LAYOUT_BYTES)
+			return _accepted[0][ptr[0]] & _accepted[1][ptr[1]] & _accepted[2][ptr[2]];
+
+		for (int c = 0; c < 3; ++c)
+		{
+			const float val = loadFloat(ptr + c * sizeof(float), _bigEndian);
+
+			//also rejects NaN
+			if (!(val >= 0.0f && val <= channelRange(c)))
+				return false;
+
+			if (!_ignored[c] && !(distance(c, val) <= _tolerance[c]))
+				return false;
+		}
+
+		return true;
+	}
+
+	//calls callback(offset) for every match starting in [begin, last)
+	template<typename Callback> void ForEachMatch(const uint8_t* data, const size_t begin, const size_t last, const uint32_t alignment, Callback callback) const
+	{
+		if (_layout == LAYOUT_FLOATS)
+		{
+			for (size_t offset = begin; offset < last; offset += alignment)
+				if (Matches(data + offset))
+					callback(offset);
+
+			return;
+		}
+
+		const uint8_t* first = _accepted[0];
+		const uint8_t* second = _accepted[1];
+		const uint8_t* third = _accepted[2];
+
+		for (size_t offset = begin; offset < last; offset += alignment)
+			if (first[data[offset]] && second[data[offset + 1]] && third[data[offset + 2]])
+				callback(offset);
+	}
+};
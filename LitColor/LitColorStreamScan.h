@@ -0,0 +1,285 @@
+﻿#pragma once
+
+#include <condition_variable>
+#include <fstream>
+#include <string>
+#include "LitColorScanner.h"
+
+#ifdef LITCOLOR_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef LITCOLOR_WITH_LZ4
+#include <lz4frame.h>
+#endif
+
+class LitColorStreamSource
+{
+public:
+	virtual ~LitColorStreamSource() = default;
+
+	//fills out with up to capacity bytes, returns 0 at the end of the stream
+	virtual size_t Read(uint8_t* out, const size_t capacity) = 0;
+
+	virtual bool HasFailed() const
+	{
+		return false;
+	}
+};
+
+class LitColorFileSource : public LitColorStreamSource
+{
+private:
+	std::ifstream _file;
+
+public:
+	LitColorFileSource(const std::string& path) : _file(path, std::ios::binary) {}
+
+	size_t Read(uint8_t* out, const size_t capacity) override
+	{
+		if (!_file)
+			return 0;
+
+		_file.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(capacity));
+		return static_cast<size_t>(_file.gcount());
+	}
+
+	bool HasFailed() const override
+	{
+		return !_file.is_open() || _file.bad();
+	}
+};
+
+#ifdef LITCOLOR_WITH_ZSTD
+class LitColorZstdSource : public LitColorStreamSource
+{
+private:
+	LitColorFileSource _file;
+	ZSTD_DCtx* _context = nullptr;
+	std::vector<uint8_t> _input;
+	ZSTD_inBuffer _inBuffer = { nullptr, 0, 0 };
+	size_t _pending = 0; //0 once a frame is complete
+	bool _failed = false;
+
+public:
+	LitColorZstdSource(const std::string& path) : _file(path), _context(ZSTD_createDCtx()), _input(ZSTD_DStreamInSize())
+	{
+		_inBuffer.src = _input.data();
+	}
+
+	~LitColorZstdSource()
+	{
+		ZSTD_freeDCtx(_context);
+	}
+
+	size_t Read(uint8_t* out, const size_t capacity) override
+	{
+		ZSTD_outBuffer outBuffer = { out, capacity, 0 };
+
+		while (outBuffer.pos < outBuffer.size && !_failed)
+		{
+			if (_inBuffer.pos == _inBuffer.size)
+			{
+				_inBuffer.size = _file.Read(_input.data(), _input.size());
+				_inBuffer.pos = 0;
+
+				//a truncated stream ends inside a frame
+				if (_inBuffer.size == 0)
+				{
+					_failed = _pending != 0;
+					break;
+				}
+			}
+
+			//handles concatenated frames as well
+			_pending = ZSTD_decompressStream(_context, &outBuffer, &_inBuffer);
+
+			if (ZSTD_isError(_pending))
+				_failed = true;
+		}
+
+		return outBuffer.pos;
+	}
+
+	bool HasFailed() const override
+	{
+		return _failed || _file.HasFailed();
+	}
+};
+#endif
+
+#ifdef LITCOLOR_WITH_LZ4
+class LitColorLz4Source : public LitColorStreamSource
+{
+private:
+	LitColorFileSource _file;
+	LZ4F_dctx* _context = nullptr;
+	std::vector<uint8_t> _input;
+	size_t _inputPos = 0;
+	size_t _inputSize = 0;
+	size_t _pending = 0; //0 once a frame is complete
+	bool _failed = false;
+
+public:
+	LitColorLz4Source(const std::string& path) : _file(path), _input(0x10000)
+	{
+		if (LZ4F_isError(LZ4F_createDecompressionContext(&_context, LZ4F_VERSION)))
+			_failed = true;
+	}
+
+	~LitColorLz4Source()
+	{
+		LZ4F_freeDecompressionContext(_context);
+	}
+
+	size_t Read(uint8_t* out, const size_t capacity) override
+	{
+		size_t produced = 0;
+
+		while (produced < capacity && !_failed)
+		{
+			if (_inputPos == _inputSize)
+			{
+				_inputSize = _file.Read(_input.data(), _input.size());
+				_inputPos = 0;
+
+				//a truncated stream ends inside a frame
+				if (_inputSize == 0)
+				{
+					_failed = _pending != 0;
+					break;
+				}
+			}
+
+			size_t outSize = capacity - produced;
+			size_t inSize = _inputSize - _inputPos;
+			_pending = LZ4F_decompress(_context, out + produced, &outSize, _input.data() + _inputPos, &inSize, nullptr);
+
+			if (LZ4F_isError(_pending))
+				_failed = true;
+
+			produced += outSize;
+			_inputPos += inSize;
+		}
+
+		return produced;
+	}
+
+	bool HasFailed() const override
+	{
+		return _failed || _file.HasFailed();
+	}
+};
+#endif
+
+class LitColorStreamScan
+{
+private:
+	struct Block
+	{
+		std::vector<uint8_t> Data;
+		size_t Size = 0;
+	};
+
+	LitColorScanner _scanner;
+	size_t _blockSize = 0x400000;
+
+public:
+	LitColorStreamScan(const LitColorScanner& scanner, const size_t blockSize = 0x400000)
+		: _scanner(scanner), _blockSize(std::max<size_t>(blockSize, 0x1000))
+	{}
+
+	//decompresses on a second thread while the previous block is scanned. Memory stays bounded by three blocks.
+	//success is set to false if the source failed, e.g. on a truncated or corrupt stream. The hits up to that point are returned
+	std::vector<LitColorHit> Scan(LitColorStreamSource& source, const uint64_t baseAddress = 0, std::shared_ptr<LitColorScanProgress> progress = nullptr, bool* success = nullptr) const
+	{
+		std::vector<LitColorHit> hits;
+		Block blocks[2];
+		size_t filled = 0;
+		size_t consumed = 0;
+		bool finished = false;
+		std::mutex mutex;
+		std::condition_variable blockChanged;
+
+		for (auto& block : blocks)
+			block.Data.resize(_blockSize);
+
+		if (progress)
+			progress->Reset(0);
+
+		std::thread producer([&]()
+		{
+			for (size_t i = 0; ; ++i)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					blockChanged.wait(lock, [&]() { return filled - consumed < 2; });
+				}
+
+				Block& block = blocks[i % 2];
+				block.Size = (progress && progress->IsCancelled()) ? 0 : source.Read(block.Data.data(), block.Data.size());
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+
+					if (block.Size == 0)
+						finished = true;
+					else
+						++filled;
+				}
+
+				blockChanged.notify_all();
+
+				if (block.Size == 0)
+					return;
+			}
+		});
+
+		const size_t valueSize = _scanner.GetValueSize();
+		const size_t alignment = _scanner.GetAlignment();
+		std::vector<uint8_t> window;
+		uint64_t windowStart = 0;
+
+		for (size_t i = 0; ; ++i)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				blockChanged.wait(lock, [&]() { return filled > consumed || finished; });
+
+				if (filled == consumed)
+					break;
+			}
+
+			//the window holds the unscanned tail of the previous block followed by the new one, so values crossing block boundaries are found
+			const Block& block = blocks[i % 2];
+			const size_t blockSize = block.Size;
+			window.insert(window.end(), block.Data.begin(), block.Data.begin() + blockSize);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				++consumed;
+			}
+
+			blockChanged.notify_all();
+			const size_t firstUnscanned = window.size() >= valueSize ? std::min((window.size() - valueSize + alignment) / alignment * alignment, window.size()) : 0;
+			_scanner.ScanRange(window.data(), window.size(), 0, firstUnscanned, baseAddress + windowStart, hits);
+
+			if (progress)
+				progress->AddBytesProcessed(blockSize);
+
+			window.erase(window.begin(), window.begin() + firstUnscanned);
+			windowStart += firstUnscanned;
+		}
+
+		producer.join();
+		_scanner.ScanRange(window.data(), window.size(), 0, window.size(), baseAddress + windowStart, hits);
+
+		if (success)
+			*success = !source.HasFailed();
+
+		if (progress)
+			progress->SetFinished();
+
+		return hits;
+	}
+};
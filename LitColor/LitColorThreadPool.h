@@ -0,0 +1,91 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//fixed set of worker threads running queued tasks in order. Tasks must not wait for other tasks of the same pool
+class LitColorThreadPool
+{
+private:
+	std::vector<std::thread> _threads;
+	std::deque<std::function<void()>> _tasks;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	bool _stopping = false;
+
+	void work()
+	{
+		for (;;)
+		{
+			std::function<void()> task;
+
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_condition.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+
+				//queued tasks still run on destruction, so nobody waits for a task that was dropped
+				if (_tasks.empty())
+					return;
+
+				task = std::move(_tasks.front());
+				_tasks.pop_front();
+			}
+
+			task();
+		}
+	}
+
+public:
+	//threadCount 0 uses all hardware threads
+	LitColorThreadPool(unsigned int threadCount = 0)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		for (unsigned int i = 0; i < threadCount; ++i)
+			_threads.emplace_back([this]() { work(); });
+	}
+
+	LitColorThreadPool(const LitColorThreadPool&) = delete;
+	LitColorThreadPool& operator=(const LitColorThreadPool&) = delete;
+
+	~LitColorThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stopping = true;
+		}
+
+		_condition.notify_all();
+
+		for (auto& thread : _threads)
+			thread.join();
+	}
+
+	//pool shared by all scanners, created on first use
+	static LitColorThreadPool& GetShared()
+	{
+		static LitColorThreadPool pool;
+		return pool;
+	}
+
+	void Submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_tasks.push_back(std::move(task));
+		}
+
+		_condition.notify_one();
+	}
+
+	unsigned int GetThreadCount() const
+	{
+		return static_cast<unsigned int>(_threads.size());
+	}
+};
@@ -0,0 +1,503 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include "LitColorScanner.h"
+
+#ifdef __linux__
+#include <climits>
+#include <sys/types.h>
+#include <sys/uio.h>
+#endif
+
+//samples candidate addresses repeatedly and classifies how their colors change over time
+class LitColorTracker
+{
+public:
+	enum Behaviors
+	{
+		BEHAVIOR_UNKNOWN,
+		BEHAVIOR_CONSTANT,
+		BEHAVIOR_PERIODIC,
+		BEHAVIOR_HUE_CYCLE,
+		BEHAVIOR_IRREGULAR
+	};
+
+	struct Result
+	{
+		uint64_t Address = 0;
+		int Type = LitColor::RGBA8888;
+		int Behavior = BEHAVIOR_UNKNOWN;
+		uint32_t Latest = 0;
+		float Period = 0.0f; //in samples
+		float HueRate = 0.0f; //degrees per sample
+		uint32_t SampleCount = 0;
+		uint32_t InvalidCount = 0;
+	};
+
+private:
+	//updated once per sample, nothing here depends on the history length
+	struct Statistics
+	{
+		uint32_t Samples = 0;
+		uint32_t Invalid = 0;
+		uint32_t Changes = 0;
+		uint32_t Previous = 0;
+		int32_t PreviousBrightness = 0;
+		int32_t PreviousHue = -1;
+		int32_t Slope = 0;
+		uint32_t LastPeak = 0;
+		uint32_t LastTrough = 0;
+		uint32_t CycleCount = 0;
+		uint32_t CycleSum = 0;
+		uint32_t MinCycle = 0xFFFFFFFF;
+		uint32_t MaxCycle = 0;
+		uint32_t HueForward = 0;
+		uint32_t HueBackward = 0;
+		uint32_t HueJumps = 0;
+		int64_t HueTravel = 0;
+	};
+
+	struct Span
+	{
+		uint64_t Address;
+		size_t Size;
+		size_t BufferOffset;
+		size_t FirstCandidate;
+		size_t CandidateCount;
+	};
+
+	static constexpr uint64_t SPAN_GAP = 64;
+	static constexpr int32_t HUE_MIN_CHROMA = 24;
+	static constexpr int32_t HUE_MAX_STEP = 90;
+	static constexpr uint32_t MIN_SAMPLES = 8;
+
+	std::vector<LitColorHit> _candidates;
+	std::vector<Statistics> _statistics;
+	std::vector<uint32_t> _history;
+	std::vector<size_t> _bufferOffsets;
+	std::vector<Span> _spans;
+	std::vector<uint8_t> _spanRead;
+	std::vector<uint8_t> _readBuffer;
+	LitColorQuery _loader;
+	size_t _historyLength = 64;
+	uint64_t _tick = 0;
+	uint64_t _missedTicks = 0;
+	mutable std::mutex _mutex;
+	std::mutex _samplingMutex;
+	std::condition_variable _samplingSignal;
+	std::thread _samplingThread;
+	bool _sampling = false;
+
+#ifdef __linux__
+	std::vector<iovec> _localIovs;
+	std::vector<iovec> _remoteIovs;
+#endif
+
+	bool decode(const uint8_t* ptr, const int type, uint32_t& rgba) const
+	{
+		switch (type)
+		{
+		case LitColor::RGB888: return _loader.LoadWord<LitColor::RGB888>(ptr, rgba);
+		case LitColor::RGBA8888: return _loader.LoadWord<LitColor::RGBA8888>(ptr, rgba);
+		case LitColor::RGBF: return _loader.LoadWord<LitColor::RGBF>(ptr, rgba);
+		case LitColor::RGBAF: return _loader.LoadWord<LitColor::RGBAF>(ptr, rgba);
+		case LitColor::RGBA16F: return _loader.LoadWord<LitColor::RGBA16F>(ptr, rgba);
+		case LitColor::RGB5A3: {
+			_loader.LoadWord<LitColor::RGB5A3>(ptr, rgba);
+			rgba = (rgba & 0x8000) ? (LitColor::RGB5A3ToRGB888(static_cast<uint16_t>(rgba)) | 0xFF) : LitColor::RGB5A3ToRGBA8888(static_cast<uint16_t>(rgba));
+		} return true;
+		case LitColor::RGB565: {
+			_loader.LoadWord<LitColor::RGB565>(ptr, rgba);
+			rgba = LitColor::RGB565ToRGB888(static_cast<uint16_t>(rgba));
+		} return true;
+		default: //e.g. HSV triples of a LitColorSpaceQuery scan
+			return false;
+		}
+	}
+
+	//degrees, -1 for colors too gray to have a stable hue
+	static int32_t hueOf(const uint32_t rgba)
+	{
+		const int32_t r = static_cast<int32_t>(rgba >> 24);
+		const int32_t g = static_cast<int32_t>((rgba >> 16) & 0xFF);
+		const int32_t b = static_cast<int32_t>((rgba >> 8) & 0xFF);
+		const int32_t max = std::max(r, std::max(g, b));
+		const int32_t chroma = max - std::min(r, std::min(g, b));
+
+		if (chroma < HUE_MIN_CHROMA)
+			return -1;
+
+		int32_t hue;
+
+		if (max == r)
+			hue = 60 * (g - b) / chroma;
+		else if (max == g)
+			hue = 120 + 60 * (b - r) / chroma;
+		else
+			hue = 240 + 60 * (r - g) / chroma;
+
+		return (hue + 360) % 360;
+	}
+
+	void record(const size_t index, const bool valid, uint32_t rgba)
+	{
+		Statistics& stats = _statistics[index];
+		uint32_t& slot = _history[index * _historyLength + _tick % _historyLength];
+
+		if (!valid)
+		{
+			++stats.Invalid;
+			slot = stats.Previous;
+			return;
+		}
+
+		slot = rgba;
+		const int32_t brightness = static_cast<int32_t>((rgba >> 24) + ((rgba >> 16) & 0xFF) + ((rgba >> 8) & 0xFF) + (rgba & 0xFF));
+		const int32_t hue = hueOf(rgba);
+
+		if (stats.Samples > 0)
+		{
+			if (rgba != stats.Previous)
+				++stats.Changes;
+
+			//a peak or trough ends whenever the brightness changes direction. Flat stretches keep the previous direction
+			const int32_t delta = brightness - stats.PreviousBrightness;
+			const int32_t slope = delta > 0 ? 1 : (delta < 0 ? -1 : 0);
+
+			if (slope != 0 && stats.Slope != 0 && slope != stats.Slope)
+			{
+				uint32_t& last = slope < 0 ? stats.LastPeak : stats.LastTrough;
+
+				if (last != 0)
+				{
+					const uint32_t cycle = stats.Samples - last;
+					++stats.CycleCount;
+					stats.CycleSum += cycle;
+					stats.MinCycle = std::min(stats.MinCycle, cycle);
+					stats.MaxCycle = std::max(stats.MaxCycle, cycle);
+				}
+
+				last = stats.Samples;
+			}
+
+			if (slope != 0)
+				stats.Slope = slope;
+
+			if (hue >= 0 && stats.PreviousHue >= 0)
+			{
+				int32_t step = hue - stats.PreviousHue;
+				step += step > 180 ? -360 : (step <= -180 ? 360 : 0);
+
+				//switching between unrelated colors has no direction
+				if (std::abs(step) >= HUE_MAX_STEP)
+					++stats.HueJumps;
+				else
+				{
+					if (step > 0)
+						++stats.HueForward;
+					else if (step < 0)
+						++stats.HueBackward;
+
+					stats.HueTravel += step;
+				}
+			}
+		}
+
+		stats.Previous = rgba;
+		stats.PreviousBrightness = brightness;
+		stats.PreviousHue = hue;
+		++stats.Samples;
+	}
+
+	Result classify(const size_t index) const
+	{
+		const Statistics& stats = _statistics[index];
+		Result result;
+		result.Address = _candidates[index].Address;
+		result.Type = _candidates[index].Type;
+		result.Latest = stats.Previous;
+		result.SampleCount = stats.Samples;
+		result.InvalidCount = stats.Invalid;
+
+		if (stats.Samples < MIN_SAMPLES)
+			return result;
+
+		if (stats.Changes == 0)
+		{
+			result.Behavior = BEHAVIOR_CONSTANT;
+			return result;
+		}
+
+		//the hue keeps turning one way, e.g. a rainbow cycle
+		const uint32_t hueSteps = stats.HueForward + stats.HueBackward;
+		const uint32_t dominantSteps = std::max(stats.HueForward, stats.HueBackward);
+
+		if (hueSteps >= 4 && dominantSteps * 10 >= (hueSteps + stats.HueJumps) * 9 && std::abs(stats.HueTravel) >= 30)
+		{
+			result.Behavior = BEHAVIOR_HUE_CYCLE;
+			result.HueRate = static_cast<float>(stats.HueTravel) / static_cast<float>(stats.Samples - 1);
+			result.Period = 360.0f / std::abs(result.HueRate);
+			return result;
+		}
+
+		//peak to peak and trough to trough distances agree, e.g. pulsing or blinking
+		if (stats.CycleCount >= 2 && stats.MaxCycle * 2 <= stats.MinCycle * 3 + 2)
+		{
+			result.Behavior = BEHAVIOR_PERIODIC;
+			result.Period = static_cast<float>(stats.CycleSum) / static_cast<float>(stats.CycleCount);
+			return result;
+		}
+
+		result.Behavior = BEHAVIOR_IRREGULAR;
+		return result;
+	}
+
+	//neighbouring candidates are read as one span so a sample takes few iovecs
+	void buildSpans()
+	{
+		size_t used = 0;
+
+		for (size_t i = 0; i < _candidates.size(); ++i)
+		{
+			const uint64_t address = _candidates[i].Address;
+			const uint64_t end = address + LitColorScanner::GetTypeSize(_candidates[i].Type);
+
+			if (_spans.empty() || address > _spans.back().Address + _spans.back().Size + SPAN_GAP)
+			{
+				_spans.push_back({ address, 0, used, i, 0 });
+			}
+
+			Span& span = _spans.back();
+			const size_t size = static_cast<size_t>(std::max<uint64_t>(end - span.Address, span.Size));
+			used += size - span.Size;
+			span.Size = size;
+			++span.CandidateCount;
+			_bufferOffsets[i] = span.BufferOffset + static_cast<size_t>(address - span.Address);
+		}
+
+		_readBuffer.resize(used);
+		_spanRead.resize(_spans.size());
+
+#ifdef __linux__
+		for (const auto& span : _spans)
+		{
+			_localIovs.push_back({ _readBuffer.data() + span.BufferOffset, span.Size });
+			_remoteIovs.push_back({ reinterpret_cast<void*>(span.Address), span.Size });
+		}
+#endif
+	}
+
+public:
+	//candidates are usually the hits of a tolerant or cross-format scan. historyLength is the number of samples kept per address
+	LitColorTracker(std::vector<LitColorHit> candidates, const bool bigEndian = true, const size_t historyLength = 64)
+		: _candidates(std::move(candidates)), _loader(LitColor(), LitColor::RGBA8888, LitColorQuery::EXACT, bigEndian), _historyLength(std::max<size_t>(historyLength, 2))
+	{
+		std::sort(_candidates.begin(), _candidates.end());
+		_statistics.resize(_candidates.size());
+		_history.resize(_candidates.size() * _historyLength);
+		_bufferOffsets.resize(_candidates.size());
+		buildSpans();
+	}
+
+	~LitColorTracker()
+	{
+		StopSampling();
+	}
+
+	LitColorTracker(const LitColorTracker&) = delete;
+	LitColorTracker& operator=(const LitColorTracker&) = delete;
+
+	size_t GetCandidateCount() const
+	{
+		return _candidates.size();
+	}
+
+	uint64_t GetSampleCount() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _tick;
+	}
+
+	//ticks StartSampling() could not keep up with
+	uint64_t GetMissedTicks() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _missedTicks;
+	}
+
+	//one sample from a dump of memory starting at baseAddress, e.g. one of many savestates. Candidates outside the dump count as invalid
+	void Sample(const uint8_t* data, const size_t size, const uint64_t baseAddress = 0)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		for (size_t i = 0; i < _candidates.size(); ++i)
+		{
+			const LitColorHit& candidate = _candidates[i];
+			const uint64_t typeSize = LitColorScanner::GetTypeSize(candidate.Type);
+			uint32_t rgba = 0;
+			const bool valid = candidate.Address >= baseAddress && candidate.Address - baseAddress + typeSize <= size
+				&& decode(data + (candidate.Address - baseAddress), candidate.Type, rgba);
+			record(i, valid, rgba);
+		}
+
+		++_tick;
+	}
+
+#ifdef __linux__
+	//one sample from a live process. All buffers are allocated up front, a sample only issues process_vm_readv calls
+	bool Sample(const pid_t pid)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		bool anyRead = false;
+
+		for (size_t first = 0; first < _spans.size(); )
+		{
+			const size_t count = std::min<size_t>(_spans.size() - first, IOV_MAX);
+			const ssize_t result = process_vm_readv(pid, &_localIovs[first], count, &_remoteIovs[first], count, 0);
+			size_t remaining = result < 0 ? 0 : static_cast<size_t>(result);
+			size_t i = first;
+
+			for (; i < first + count && remaining >= _spans[i].Size; ++i)
+			{
+				remaining -= _spans[i].Size;
+				_spanRead[i] = true;
+				anyRead = true;
+			}
+
+			//the read stops at the first span that isn't mapped, skip it and carry on behind it
+			if (i < first + count)
+				_spanRead[i++] = false;
+
+			first = i;
+		}
+
+		for (size_t s = 0; s < _spans.size(); ++s)
+		{
+			const Span& span = _spans[s];
+
+			for (size_t i = span.FirstCandidate; i < span.FirstCandidate + span.CandidateCount; ++i)
+			{
+				uint32_t rgba = 0;
+				const bool valid = _spanRead[s] && decode(_readBuffer.data() + _bufferOffsets[i], _candidates[i].Type, rgba);
+				record(i, valid, rgba);
+			}
+		}
+
+		++_tick;
+		return anyRead;
+	}
+
+	//samples pid at a fixed rate on a background thread until StopSampling() is called
+	void StartSampling(const pid_t pid, const double frequency)
+	{
+		StopSampling();
+		std::lock_guard<std::mutex> lock(_samplingMutex);
+		_sampling = true;
+
+		_samplingThread = std::thread([this, pid, frequency]()
+		{
+			const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / std::max(frequency, 0.001)));
+			auto next = std::chrono::steady_clock::now();
+			std::unique_lock<std::mutex> threadLock(_samplingMutex);
+
+			while (_sampling)
+			{
+				threadLock.unlock();
+				Sample(pid);
+				threadLock.lock();
+				next += interval;
+				const auto now = std::chrono::steady_clock::now();
+
+				//ticks that already passed are dropped rather than sampled in a burst
+				if (next < now)
+				{
+					const uint64_t missed = static_cast<uint64_t>((now - next) / interval) + 1;
+					next += interval * missed;
+					std::lock_guard<std::mutex> dataLock(_mutex);
+					_missedTicks += missed;
+				}
+
+				_samplingSignal.wait_until(threadLock, next, [this]() { return !_sampling; });
+			}
+		});
+	}
+#endif
+
+	void StopSampling()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_samplingMutex);
+			_sampling = false;
+		}
+
+		_samplingSignal.notify_all();
+
+		if (_samplingThread.joinable())
+			_samplingThread.join();
+	}
+
+	bool IsSampling()
+	{
+		std::lock_guard<std::mutex> lock(_samplingMutex);
+		return _sampling;
+	}
+
+	//candidates are ordered by address
+	Result GetResult(const size_t index) const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return classify(index);
+	}
+
+	std::vector<Result> GetResults() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::vector<Result> results(_candidates.size());
+
+		for (size_t i = 0; i < _candidates.size(); ++i)
+			results[i] = classify(i);
+
+		return results;
+	}
+
+	std::vector<Result> GetResults(const int behavior) const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::vector<Result> results;
+
+		for (size_t i = 0; i < _candidates.size(); ++i)
+		{
+			const Result result = classify(i);
+
+			if (result.Behavior == behavior)
+				results.push_back(result);
+		}
+
+		return results;
+	}
+
+	//the last samples of a candidate as RGBA8888, oldest first. Invalid samples repeat the previous value
+	std::vector<uint32_t> GetHistory(const size_t index) const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		const size_t count = static_cast<size_t>(std::min<uint64_t>(_tick, _historyLength));
+		std::vector<uint32_t> history(count);
+
+		for (size_t i = 0; i < count; ++i)
+			history[i] = _history[index * _historyLength + (_tick - count + i) % _historyLength];
+
+		return history;
+	}
+
+	void Reset()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::fill(_statistics.begin(), _statistics.end(), Statistics());
+		std::fill(_history.begin(), _history.end(), 0);
+		_tick = 0;
+		_missedTicks = 0;
+	}
+};
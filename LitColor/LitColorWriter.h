@@ -0,0 +1,215 @@
+﻿#pragma once
+
+#ifdef __linux__
+
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <numeric>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "LitColorScanner.h"
+
+class LitColorWriter
+{
+private:
+	struct Patch
+	{
+		uint64_t Address;
+		uint8_t Size;
+		uint8_t Bytes[16];
+	};
+
+	pid_t _pid = 0;
+	std::vector<Patch> _patches;
+	std::vector<uint8_t> _data;
+	std::vector<size_t> _dataOffsets;
+	std::vector<iovec> _localIovs;
+	std::vector<iovec> _remoteIovs;
+	bool _compiled = false;
+	std::mutex _mutex;
+	std::condition_variable _freezeSignal;
+	std::thread _freezeThread;
+	bool _freezing = false;
+
+	void compile()
+	{
+		//overlapping patches are merged into one run by address, then copied in the order they were added so later patches win
+		std::vector<size_t> order(_patches.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [this](const size_t a, const size_t b) { return _patches[a].Address < _patches[b].Address; });
+		_data.clear();
+		_localIovs.clear();
+		_remoteIovs.clear();
+		_dataOffsets.resize(_patches.size());
+		std::vector<std::pair<uint64_t, size_t>> runs; //address, data offset
+		uint64_t runEnd = 0;
+
+		for (const size_t index : order)
+		{
+			const Patch& patch = _patches[index];
+
+			if (runs.empty() || patch.Address > runEnd)
+			{
+				runs.emplace_back(patch.Address, _data.size());
+				runEnd = patch.Address;
+			}
+
+			const uint64_t patchEnd = patch.Address + patch.Size;
+
+			if (patchEnd > runEnd)
+			{
+				_data.resize(_data.size() + static_cast<size_t>(patchEnd - runEnd));
+				runEnd = patchEnd;
+			}
+
+			_dataOffsets[index] = runs.back().second + static_cast<size_t>(patch.Address - runs.back().first);
+		}
+
+		for (size_t i = 0; i < _patches.size(); ++i)
+			std::memcpy(_data.data() + _dataOffsets[i], _patches[i].Bytes, _patches[i].Size);
+
+		for (size_t i = 0; i < runs.size(); ++i)
+		{
+			const size_t end = i + 1 < runs.size() ? runs[i + 1].second : _data.size();
+			_localIovs.push_back({ _data.data() + runs[i].second, end - runs[i].second });
+			_remoteIovs.push_back({ reinterpret_cast<void*>(runs[i].first), end - runs[i].second });
+		}
+
+		_compiled = true;
+	}
+
+	size_t writeCompiled()
+	{
+		if (!_compiled)
+			compile();
+
+		size_t written = 0;
+
+		for (size_t first = 0; first < _localIovs.size(); first += IOV_MAX)
+		{
+			const size_t count = std::min<size_t>(IOV_MAX, _localIovs.size() - first);
+			size_t expected = 0;
+
+			for (size_t i = first; i < first + count; ++i)
+				expected += _localIovs[i].iov_len;
+
+			const ssize_t result = process_vm_writev(_pid, &_localIovs[first], count, &_remoteIovs[first], count, 0);
+
+			if (result == static_cast<ssize_t>(expected))
+			{
+				written += expected;
+				continue;
+			}
+
+			//the batch stopped at an unwritable address, write the rest one by one
+			for (size_t i = first; i < first + count; ++i)
+			{
+				const ssize_t single = process_vm_writev(_pid, &_localIovs[i], 1, &_remoteIovs[i], 1, 0);
+
+				if (single > 0)
+					written += static_cast<size_t>(single);
+			}
+		}
+
+		return written;
+	}
+
+public:
+	LitColorWriter(const pid_t pid) : _pid(pid) {}
+
+	~LitColorWriter()
+	{
+		StopFreeze();
+	}
+
+	//false for types that cannot be encoded, i.e. those of LitColorSpaceQuery
+	bool Add(const uint64_t address, const LitColor& color, const int type, const bool bigEndian = true)
+	{
+		Patch patch;
+		patch.Address = address;
+		patch.Size = static_cast<uint8_t>(LitColorScanner::GetTypeSize(type));
+
+		if (!LitColorScanner::EncodeAt(patch.Bytes, color, type, bigEndian))
+			return false;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_patches.push_back(patch);
+		_compiled = false;
+		return true;
+	}
+
+	void Add(const std::vector<LitColorHit>& hits, const LitColor& color, const bool bigEndian = true)
+	{
+		for (const auto& hit : hits)
+			Add(hit.Address, color, hit.Type, bigEndian);
+	}
+
+	void Clear()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_patches.clear();
+		_compiled = false;
+	}
+
+	size_t GetPatchCount()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _patches.size();
+	}
+
+	size_t GetIovecCount()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (!_compiled)
+			compile();
+
+		return _localIovs.size();
+	}
+
+	size_t Write()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return writeCompiled();
+	}
+
+	void StartFreeze(const std::chrono::milliseconds interval)
+	{
+		StopFreeze();
+		std::lock_guard<std::mutex> lock(_mutex);
+		_freezing = true;
+
+		_freezeThread = std::thread([this, interval]()
+		{
+			std::unique_lock<std::mutex> threadLock(_mutex);
+
+			while (_freezing)
+			{
+				writeCompiled();
+				_freezeSignal.wait_for(threadLock, interval, [this]() { return !_freezing; });
+			}
+		});
+	}
+
+	void StopFreeze()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_freezing = false;
+		}
+
+		_freezeSignal.notify_all();
+
+		if (_freezeThread.joinable())
+			_freezeThread.join();
+	}
+
+	bool IsFreezing()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _freezing;
+	}
+};
+
+#endif
@@ -0,0 +1,89 @@
+﻿#include <random>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorArrayScanner.h"
+
+//records of 32 bytes starting at first, with a color at 12 and unrelated values at 20
+static std::vector<uint8_t> makeRecords(const size_t count, const size_t first = 0)
+{
+	std::vector<uint8_t> data(first + count * 32, 0);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		LitColorScanner::WriteValue<uint32_t>(data.data() + first + i * 32 + 12, 0xFF000000u | static_cast<uint32_t>(i) << 8 | 0xFF, true);
+		LitColorScanner::WriteValue<uint32_t>(data.data() + first + i * 32 + 20, static_cast<uint32_t>(i * 0x9E3779B9u), true);
+	}
+
+	return data;
+}
+
+static void testFieldOffset()
+{
+	const std::vector<uint8_t> data = makeRecords(8);
+	const std::vector<LitColorArrayHit> hits = LitColorArrayScanner(LitColor::RGBA8888, 32, 12).Scan(data.data(), data.size(), 0x1000);
+
+	CHECK(hits.size() == 1);
+	CHECK(hits[0].Address == 0x100C);
+	CHECK(hits[0].RecordAddress == 0x1000);
+	CHECK(hits[0].RecordCount == 8);
+	CHECK(hits[0].Stride == 32);
+
+	//a field that doesn't fit into the record finds nothing
+	CHECK(LitColorArrayScanner(LitColor::RGBA8888, 32, 30).Scan(data.data(), data.size(), 0x1000).empty());
+}
+
+static void testAnyFieldOffset()
+{
+	const std::vector<uint8_t> data = makeRecords(8);
+	const std::vector<LitColorArrayHit> hits = LitColorArrayScanner(LitColor::RGBA8888, 32).Scan(data.data(), data.size(), 0x1000);
+
+	CHECK(hits.size() == 1);
+	CHECK(hits[0].Address == 0x100C && hits[0].RecordAddress == 0x1000);
+}
+
+//records that don't start at a multiple of the stride from data are found at their own phase
+static void testRecordPhase()
+{
+	const std::vector<uint8_t> data = makeRecords(8, 8);
+	const std::vector<LitColorArrayHit> hits = LitColorArrayScanner(LitColor::RGBA8888, 32, 12).Scan(data.data(), data.size(), 0x1000);
+
+	CHECK(hits.size() == 1);
+	CHECK(hits[0].Address == 0x1014);
+	CHECK(hits[0].RecordAddress == 0x1008);
+	CHECK(hits[0].RecordCount == 8);
+
+	//the color at address 12 is found as field 12 of a record at 0, as field 24 its record would start before address 0
+	CHECK(LitColorArrayScanner(LitColor::RGBA8888, 32, 12).Scan(data.data() + 8, data.size() - 8, 0).size() == 1);
+	CHECK(LitColorArrayScanner(LitColor::RGBA8888, 32, 24).Scan(data.data() + 8, data.size() - 8, 0).empty());
+}
+
+//any bits are valid packed colors, still random data holds no arrays
+static void testRandomData()
+{
+	std::mt19937 random(99);
+	std::vector<uint8_t> data(0x100000);
+
+	for (auto& byte : data)
+		byte = static_cast<uint8_t>(random());
+
+	CHECK(LitColorArrayScanner(LitColor::RGBA8888, 32, 12).Scan(data.data(), data.size()).empty());
+	CHECK(LitColorArrayScanner(LitColor::RGBA8888, 32).Scan(data.data(), data.size()).empty());
+	CHECK(LitColorArrayScanner(LitColor::RGB888, 12).Scan(data.data(), data.size()).empty());
+	CHECK(LitColorArrayScanner(LitColor::RGB565, 16).Scan(data.data(), data.size()).empty());
+	CHECK(LitColorArrayScanner(LitColor::RGB5A3, 16, 0, 4, true, 2).Scan(data.data(), data.size()).empty());
+	CHECK(LitColorArrayScanner(LitColor::RGBAF, 32).Scan(data.data(), data.size()).empty());
+
+	//unless every step is allowed
+	LitColorArrayScanner any(LitColor::RGB565, 16);
+	any.SetMaxStep(255);
+	CHECK(!any.Scan(data.data(), data.size()).empty());
+}
+
+int main()
+{
+	testFieldOffset();
+	testAnyFieldOffset();
+	testRecordPhase();
+	testRandomData();
+	return 0;
+}
@@ -0,0 +1,107 @@
+﻿#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorBatchScan.h"
+
+static std::string tempPath(const std::string& name)
+{
+	return (std::filesystem::temp_directory_path() / ("litcolor_" + name)).string();
+}
+
+static void writeFile(const std::string& path, const std::vector<uint8_t>& data)
+{
+	std::ofstream file(path, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+//colors at the start, across every chunk boundary and at the end
+static std::vector<uint8_t> makeDump()
+{
+	std::vector<uint8_t> dump(0x4000, 0);
+	const uint64_t offsets[] = { 0, 0xFFE, 0x1FFD, 0x2FFF, 0x3FFC };
+
+	for (const uint64_t offset : offsets)
+		LitColorScanner::WriteValue<uint32_t>(dump.data() + offset, 0xFF8020FFu, true);
+
+	return dump;
+}
+
+//hits at one address may come in any type order
+static std::vector<LitColorHit> sorted(std::vector<LitColorHit> hits)
+{
+	std::sort(hits.begin(), hits.end(), [](const LitColorHit& a, const LitColorHit& b) { return a.Address != b.Address ? a.Address < b.Address : a.Type < b.Type; });
+	return hits;
+}
+
+//chunked results must equal a scan of the whole dump, with one or many threads
+static void checkScanner(const LitColorScanner& scanner, const std::vector<std::string>& paths, const std::vector<uint8_t>& dump)
+{
+	const std::vector<LitColorHit> expected = sorted(scanner.Scan(dump.data(), dump.size(), 0x1000));
+	CHECK(!expected.empty());
+
+	for (const unsigned int threadCount : { 1u, 4u })
+	{
+		LitColorBatchScan batch(scanner, 0x1000, threadCount, 2);
+		batch.SetChunkSize(0x1000);
+		CHECK(batch.GetChunkSize() == 0x1000);
+		const std::vector<LitColorDumpResult> results = batch.Run(paths);
+		CHECK(results.size() == paths.size());
+
+		for (const LitColorDumpResult& result : results)
+		{
+			const std::vector<LitColorHit> hits = sorted(result.Hits);
+			CHECK(result.Success);
+			CHECK(hits.size() == expected.size());
+
+			for (size_t i = 0; i < expected.size() && i < hits.size(); ++i)
+				CHECK(hits[i].Address == expected[i].Address && hits[i].Type == expected[i].Type);
+		}
+	}
+}
+
+static void testChunkBoundaries()
+{
+	const std::vector<uint8_t> dump = makeDump();
+	const std::vector<std::string> paths = { tempPath("batch1.bin"), tempPath("batch2.bin") };
+
+	for (const std::string& path : paths)
+		writeFile(path, dump);
+
+	checkScanner(LitColorScanner(LitColor(0xFF8020FFu), LitColor::RGBA8888, true, 1), paths, dump);
+	checkScanner(LitColorScanner(LitColor(0xFF8020FFu), LitColor::RGBA8888, true, 4), paths, dump);
+	checkScanner(LitColorScanner(LitColorCrossFormatQuery(LitColor(0xFF8020FFu)), 1), paths, dump);
+
+	for (const std::string& path : paths)
+		std::filesystem::remove(path);
+}
+
+//a dump that cannot be read fails on its own and progress still completes
+static void testMissingDump()
+{
+	const std::vector<uint8_t> dump = makeDump();
+	const std::string path = tempPath("batch3.bin");
+	writeFile(path, dump);
+
+	const LitColorScanner scanner(LitColor(0xFF8020FFu), LitColor::RGBA8888, true, 1);
+	auto progress = std::make_shared<LitColorScanProgress>();
+	LitColorBatchScan batch(scanner, 0, 2);
+	batch.SetChunkSize(0x1000);
+	const std::vector<LitColorDumpResult> results = batch.RunAsync({ tempPath("missing.bin"), path }, progress).get();
+	CHECK(results.size() == 2);
+	CHECK(!results[0].Success && results[0].Hits.empty());
+	CHECK(results[1].Success && results[1].Hits.size() == 5);
+	CHECK(progress->IsFinished());
+	CHECK(progress->GetBytesProcessed() == progress->GetBytesTotal());
+	std::filesystem::remove(path);
+}
+
+int main()
+{
+	testChunkBoundaries();
+	testMissingDump();
+	return 0;
+}
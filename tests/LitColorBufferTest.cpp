@@ -0,0 +1,88 @@
+﻿#include <cmath>
+#include <cstring>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorBuffer.h"
+
+static const int TYPES[] = { LitColor::RGB888, LitColor::RGBA8888, LitColor::RGBF, LitColor::RGBAF, LitColor::RGB565, LitColor::RGB5A3, LitColor::RGBA16F };
+
+static std::vector<uint8_t> floatBytes(const std::vector<float>& values)
+{
+	std::vector<uint8_t> bytes(values.size() * sizeof(float));
+	std::memcpy(bytes.data(), values.data(), bytes.size());
+	return bytes;
+}
+
+//out of range channels clamp instead of dropping to 0
+static void testLoadFloats()
+{
+	const std::vector<uint8_t> bytes = floatBytes({ 1.2f, -0.5f, 0.5f, NAN, INFINITY, 0.2f });
+	LitColorBuffer buffer;
+	buffer.LoadFromMemory(bytes.data(), 2, LitColor::RGBF, false);
+
+	CHECK(buffer.GetChannel(LitColor::RED)[0] == 255);
+	CHECK(buffer.GetChannel(LitColor::GREEN)[0] == 0);
+	CHECK(buffer.GetChannel(LitColor::BLUE)[0] == 128);
+	CHECK(buffer.GetChannel(LitColor::RED)[1] == 0);
+	CHECK(buffer.GetChannel(LitColor::GREEN)[1] == 255);
+	CHECK(buffer.GetChannel(LitColor::BLUE)[1] == 51);
+
+	//halves above 1.0 and negative ones
+	const uint16_t halves[4] = { 0x3C01, 0xBC00, 0x3800, 0x7C00 };
+	uint8_t halfBytes[8];
+	std::memcpy(halfBytes, halves, sizeof(halves));
+	buffer.LoadFromMemory(halfBytes, 1, LitColor::RGBA16F, false);
+	CHECK(buffer.GetRGBA()[0] == 0xFF0080FFu);
+}
+
+//every channel value times a few factors gives what a single LitColor gives
+static void testMultiply()
+{
+	for (const float factor : { 0.5f, 0.3f, 1.0f, 1.7f, 0.0f })
+	{
+		LitColorBuffer buffer(false);
+
+		for (uint32_t val = 0; val < 256; ++val)
+			buffer.PushBack(LitColor(val << 24 | val << 16 | val << 8 | 0xFF, false));
+
+		buffer.Multiply(factor);
+
+		for (uint32_t val = 0; val < 256; ++val)
+		{
+			const LitColor expected = LitColor(val << 24 | val << 16 | val << 8 | 0xFF, false) * factor;
+			CHECK((buffer.GetRGBA()[val] & 0xFFFFFF00u) == (expected.GetRGBA() & 0xFFFFFF00u));
+		}
+	}
+}
+
+//stored colors load back the same in either byte order
+static void testRoundTrip()
+{
+	LitColorBuffer buffer;
+
+	for (uint32_t i = 0; i < 64; ++i)
+		buffer.PushBack(LitColor(0x10204080u + i * 0x01030507u));
+
+	for (const int type : TYPES)
+		for (const bool bigEndian : { true, false })
+		{
+			std::vector<uint8_t> bytes(64 * 16);
+			buffer.StoreToMemory(bytes.data(), type, bigEndian);
+			LitColorBuffer loaded;
+			loaded.LoadFromMemory(bytes.data(), 64, type, bigEndian);
+			std::vector<uint8_t> again(bytes.size());
+			loaded.StoreToMemory(again.data(), type, bigEndian);
+			CHECK(again == bytes);
+
+			if (type == LitColor::RGBA8888 || type == LitColor::RGBAF || type == LitColor::RGBA16F)
+				CHECK(loaded.GetRGBA() == buffer.GetRGBA());
+		}
+}
+
+int main()
+{
+	testLoadFloats();
+	testMultiply();
+	testRoundTrip();
+	return 0;
+}
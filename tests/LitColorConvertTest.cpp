@@ -0,0 +1,181 @@
+﻿#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorConvert.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LITCOLOR_TEST_F16C
+#endif
+
+static uint8_t referenceSrgb(const float linear)
+{
+	return static_cast<uint8_t>(LitColor::FloatToChannel(linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f));
+}
+
+//half of the inputs near black, where the curve is steepest
+static void testSrgbEncode()
+{
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> dark(0.0f, 0.01f);
+	std::uniform_real_distribution<float> full(0.0f, 1.0f);
+	std::vector<float> src(4 * 250000);
+
+	for (size_t i = 0; i < src.size(); ++i)
+		src[i] = i % 2 ? dark(random) : full(random);
+
+	src[0] = -1.0f;
+	src[1] = 0.0f;
+	src[2] = 1.0f;
+	src[4] = NAN;
+	src[5] = 0.0031308f;
+	src[6] = INFINITY;
+	std::vector<uint8_t> dst(src.size());
+	LitColorConvert::LinearFloatToSrgbBytes(src.data(), dst.data(), src.size() / 4);
+
+	for (size_t i = 0; i < src.size(); ++i)
+		CHECK(dst[i] == (i % 4 == 3 ? LitColor::FloatToChannel(src[i]) : referenceSrgb(src[i])));
+}
+
+//the SIMD path and its tail against the scalar rounding, ties and invalid values included
+static void testFloatToBytes()
+{
+	std::vector<float> src = { NAN, -NAN, INFINITY, -INFINITY, -0.0f, 0.0f, -1.0f, 1.0f, 2.0f, 0.5f / 255.0f, 1.5f / 255.0f, 127.5f / 255.0f, 254.5f / 255.0f, 1e-30f, 0.99999f };
+
+	for (int i = 0; i <= 255 * 8; ++i)
+		src.push_back(static_cast<float>(i) / (255.0f * 8.0f));
+
+	for (size_t count = src.size() - 3; count <= src.size(); ++count)
+	{
+		std::vector<uint8_t> dst(count);
+		LitColorConvert::FloatToBytes(src.data(), dst.data(), count);
+
+		for (size_t i = 0; i < count; ++i)
+			CHECK(dst[i] == LitColor::FloatToChannel(src[i]));
+	}
+}
+
+//4 pixels per SIMD step, every tail length
+static void testRgbfToRgba()
+{
+	std::vector<float> src = { NAN, -1.0f, 2.0f, INFINITY, -INFINITY, 0.5f / 255.0f, 1.5f / 255.0f, 254.5f / 255.0f };
+
+	for (int i = 0; i < 3 * 41; ++i)
+		src.push_back(static_cast<float>(i * 7 % 256) / 255.0f);
+
+	for (size_t pixelCount = 39; pixelCount <= src.size() / 3; ++pixelCount)
+	{
+		std::vector<uint8_t> dst(pixelCount * 4);
+		LitColorConvert::RGBFToRGBA8888(src.data(), dst.data(), pixelCount, 0x7F);
+
+		for (size_t i = 0; i < pixelCount; ++i)
+		{
+			for (size_t j = 0; j < 3; ++j)
+				CHECK(dst[i * 4 + j] == LitColor::FloatToChannel(src[i * 3 + j]));
+
+			CHECK(dst[i * 4 + 3] == 0x7F);
+		}
+	}
+}
+
+static uint32_t floatBits(const float val)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &val, sizeof(bits));
+	return bits;
+}
+
+//same bits, any NaN matches any NaN since payloads differ between implementations
+static bool sameFloat(const float a, const float b)
+{
+	return std::isnan(a) ? std::isnan(b) : floatBits(a) == floatBits(b);
+}
+
+static bool sameHalf(const uint16_t a, const uint16_t b)
+{
+	const bool aNan = (a & 0x7FFF) > 0x7C00;
+	const bool bNan = (b & 0x7FFF) > 0x7C00;
+	return aNan || bNan ? aNan == bNan : a == b;
+}
+
+//floats around every half, halfway between neighbours and beyond the half range
+static std::vector<float> makeHalfInputs()
+{
+	std::vector<float> src = { NAN, -NAN, INFINITY, -INFINITY, 65504.0f, 65520.0f, 65519.99f, 1e-8f, 2.98e-8f, 2.99e-8f, 1e10f, -1e-30f };
+
+	for (uint32_t half = 0; half < 0x7C00; ++half)
+	{
+		const float val = LitColor::HalfToFloat(static_cast<uint16_t>(half));
+		const float next = LitColor::HalfToFloat(static_cast<uint16_t>(half + 1));
+		src.push_back(val);
+		src.push_back(-val);
+		src.push_back((val + next) * 0.5f);
+		src.push_back(std::nextafter((val + next) * 0.5f, 0.0f));
+		src.push_back(-std::nextafter((val + next) * 0.5f, INFINITY));
+	}
+
+	return src;
+}
+
+#ifdef LITCOLOR_TEST_F16C
+__attribute__((target("f16c"))) static float f16cHalfToFloat(const uint16_t half)
+{
+	return _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(half)));
+}
+
+__attribute__((target("f16c"))) static uint16_t f16cFloatToHalf(const float val)
+{
+	return static_cast<uint16_t>(_mm_cvtsi128_si32(_mm_cvtps_ph(_mm_set_ss(val), _MM_FROUND_TO_NEAREST_INT)));
+}
+#endif
+
+//every half through the bulk and scalar paths, and through F16C where the CPU has it
+static void testHalfToFloat()
+{
+	std::vector<uint16_t> src(0x10000);
+
+	for (size_t i = 0; i < src.size(); ++i)
+		src[i] = static_cast<uint16_t>(i);
+
+	std::vector<float> dst(src.size());
+	LitColorConvert::HalfToFloat(src.data(), dst.data(), src.size());
+
+	for (size_t i = 0; i < src.size(); ++i)
+	{
+		CHECK(sameFloat(dst[i], LitColor::HalfToFloat(src[i])));
+
+#ifdef LITCOLOR_TEST_F16C
+		if (__builtin_cpu_supports("f16c"))
+			CHECK(sameFloat(dst[i], f16cHalfToFloat(src[i])));
+#endif
+	}
+}
+
+static void testFloatToHalf()
+{
+	const std::vector<float> src = makeHalfInputs();
+	std::vector<uint16_t> dst(src.size());
+	LitColorConvert::FloatToHalf(src.data(), dst.data(), src.size());
+
+	for (size_t i = 0; i < src.size(); ++i)
+	{
+		CHECK(sameHalf(dst[i], LitColor::FloatToHalf(src[i])));
+
+#ifdef LITCOLOR_TEST_F16C
+		if (__builtin_cpu_supports("f16c"))
+			CHECK(sameHalf(dst[i], f16cFloatToHalf(src[i])));
+#endif
+	}
+}
+
+int main()
+{
+	testSrgbEncode();
+	testFloatToBytes();
+	testRgbfToRgba();
+	testHalfToFloat();
+	testFloatToHalf();
+	return 0;
+}
@@ -0,0 +1,134 @@
+﻿#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorHistogram.h"
+
+static const uint32_t RED = 0xFF0000FFu;
+static const uint32_t GREEN = 0x00FF00FFu;
+static const uint32_t BLUE = 0x0000FFFFu;
+
+//600 red, 300 green and 100 blue records of 8 bytes, the second word of each record is junk
+static std::vector<uint8_t> makeRecords()
+{
+	std::vector<uint8_t> data(1000 * 8);
+
+	for (size_t i = 0; i < 1000; ++i)
+	{
+		LitColorScanner::WriteValue<uint32_t>(data.data() + i * 8, i % 10 < 6 ? RED : (i % 10 < 9 ? GREEN : BLUE), true);
+		LitColorScanner::WriteValue<uint32_t>(data.data() + i * 8 + 4, static_cast<uint32_t>(i * 0x9E3779B9u), true);
+	}
+
+	return data;
+}
+
+//one thread and many threads count the same
+static void testCounts()
+{
+	const std::vector<uint8_t> data = makeRecords();
+
+	for (const unsigned int threadCount : { 1u, 3u, 8u })
+	{
+		LitColorHistogram histogram(LitColor::RGBA8888, true, 8, threadCount);
+		histogram.Build(data.data(), data.size());
+		CHECK(histogram.GetTotal() == 1000);
+		CHECK(histogram.GetInvalidCount() == 0);
+		CHECK(histogram.GetUniqueCount() == 3);
+		CHECK(histogram.GetCount(LitColor(GREEN)) == 300);
+		CHECK(histogram.GetCount(LitColor(0x123456FFu)) == 0);
+
+		const std::vector<LitColorHistogram::Entry> top = histogram.GetTop(2);
+		CHECK(top.size() == 2);
+		CHECK(top[0].Color.GetRGBA() == RED && top[0].Count == 600);
+		CHECK(top[1].Color.GetRGBA() == GREEN && top[1].Count == 300);
+	}
+
+	//every word, the junk included
+	LitColorHistogram words(LitColor::RGBA8888);
+	words.Build(data.data(), data.size() - 1);
+	CHECK(words.GetTotal() == 1999);
+	CHECK(words.GetCount(LitColor(RED)) == 600);
+}
+
+//floats out of 0.0 - 1.0 and NaN count as invalid
+static void testInvalidFloats()
+{
+	const float values[] = { 1.0f, 0.0f, 0.0f, 1.0f, NAN, 0.0f, 0.0f, 1.0f, 2.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f };
+	std::vector<uint8_t> data(sizeof(values));
+
+	for (size_t i = 0; i < 16; ++i)
+		LitColorScanner::WriteValue<float>(data.data() + i * 4, values[i], false);
+
+	LitColorHistogram histogram(LitColor::RGBAF, false, 0, 2);
+	histogram.Build(data.data(), data.size());
+	CHECK(histogram.GetTotal() == 4);
+	CHECK(histogram.GetInvalidCount() == 2);
+	CHECK(histogram.GetCount(LitColor(RED)) == 2);
+}
+
+//16 bit codes are counted in dense tables and reported as the colors they expand to
+static void testDense()
+{
+	std::vector<uint8_t> data(0x2000 * 2);
+
+	for (size_t i = 0; i < 0x2000; ++i)
+		LitColorScanner::WriteValue<uint16_t>(data.data() + i * 2, static_cast<uint16_t>(i % 4 ? 0xF800 : 0x07E0), false);
+
+	LitColorHistogram histogram(LitColor::RGB565, false, 0, 4);
+	histogram.Build(data.data(), data.size());
+	CHECK(histogram.GetUniqueCount() == 2);
+	CHECK(histogram.GetCount(LitColor(LitColor::RGB565ToRGB888(0xF800))) == 0x1800);
+	CHECK(histogram.GetTop(1)[0].Color.GetRGBA() == LitColor::RGB565ToRGB888(0xF800));
+}
+
+//noisy clusters reduce to their centers, every value is counted once
+static void testPalette()
+{
+	const uint32_t centers[3] = { 0xE02020FFu, 0x20C040FFu, 0x3040D0FFu };
+	const uint64_t weights[3] = { 5000, 3000, 2000 };
+	std::mt19937 random(7);
+	std::uniform_int_distribution<int> noise(-6, 6);
+	std::vector<uint8_t> data;
+
+	for (int c = 0; c < 3; ++c)
+	{
+		for (uint64_t i = 0; i < weights[c]; ++i)
+		{
+			uint32_t rgba = 0xFF;
+
+			for (int channel = 0; channel < 3; ++channel)
+				rgba |= static_cast<uint32_t>(static_cast<int>((centers[c] >> (24 - channel * 8)) & 0xFF) + noise(random)) << (24 - channel * 8);
+
+			data.resize(data.size() + 4);
+			LitColorScanner::WriteValue<uint32_t>(data.data() + data.size() - 4, rgba, true);
+		}
+	}
+
+	LitColorHistogram histogram(LitColor::RGBA8888);
+	histogram.Build(data.data(), data.size());
+	CHECK(histogram.GetUniqueCount() > 3);
+	const std::vector<LitColorHistogram::Entry> palette = histogram.ExtractPalette(3);
+	CHECK(palette.size() == 3);
+
+	for (int c = 0; c < 3; ++c)
+	{
+		const uint32_t rgba = palette[c].Color.GetRGBA();
+		CHECK(palette[c].Count == weights[c]);
+
+		for (int channel = 0; channel < 3; ++channel)
+			CHECK(std::abs(static_cast<int>((rgba >> (24 - channel * 8)) & 0xFF) - static_cast<int>((centers[c] >> (24 - channel * 8)) & 0xFF)) <= 2);
+	}
+
+	CHECK(histogram.ExtractPalette(0).empty());
+	CHECK(histogram.ExtractPalette(histogram.GetUniqueCount() + 1).size() == histogram.GetUniqueCount());
+}
+
+int main()
+{
+	testCounts();
+	testInvalidFloats();
+	testDense();
+	testPalette();
+	return 0;
+}
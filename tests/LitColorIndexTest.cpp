@@ -0,0 +1,119 @@
+﻿#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorIndex.h"
+
+static void toCoords(const int space, const uint32_t rgba, float* coords)
+{
+	if (space == LitColorIndex::SPACE_LAB)
+	{
+		LitColorIndex::ToLab(rgba, coords);
+		coords[3] = 0.0f;
+		return;
+	}
+
+	for (int i = 0; i < 4; ++i)
+		coords[i] = static_cast<float>((rgba >> (24 - i * 8)) & 0xFF);
+
+	if (space == LitColorIndex::SPACE_RGB)
+		coords[3] = 0.0f;
+}
+
+//distances of every color to reference, closest first
+static std::vector<float> bruteForce(const int space, const std::vector<uint32_t>& colors, const uint32_t reference)
+{
+	float query[4];
+	toCoords(space, reference, query);
+	std::vector<float> distances;
+
+	for (const uint32_t rgba : colors)
+	{
+		float coords[4];
+		toCoords(space, rgba, coords);
+		float sum = 0.0f;
+
+		for (int i = 0; i < 4; ++i)
+			sum += (coords[i] - query[i]) * (coords[i] - query[i]);
+
+		distances.push_back(std::sqrt(sum));
+	}
+
+	std::sort(distances.begin(), distances.end());
+	return distances;
+}
+
+static bool near(const float a, const float b)
+{
+	return std::fabs(a - b) <= 0.001f * std::max(1.0f, std::fabs(b));
+}
+
+//the tree, built serially and in parallel, agrees with a linear search
+static void testAgainstBruteForce()
+{
+	std::mt19937 random(99);
+	std::vector<uint32_t> colors(0x12000);
+
+	for (auto& rgba : colors)
+		rgba = static_cast<uint32_t>(random());
+
+	for (const int space : { LitColorIndex::SPACE_RGB, LitColorIndex::SPACE_RGBA, LitColorIndex::SPACE_LAB })
+	{
+		for (const unsigned int threadCount : { 1u, 4u })
+		{
+			LitColorIndex index(space);
+			index.Build(colors, threadCount);
+			CHECK(index.GetSize() == colors.size());
+
+			for (int q = 0; q < 8; ++q)
+			{
+				const uint32_t reference = static_cast<uint32_t>(random());
+				const std::vector<float> expected = bruteForce(space, colors, reference);
+				const std::vector<LitColorIndex::Result> nearest = index.FindNearest(LitColor(reference), 5);
+				CHECK(nearest.size() == 5);
+
+				for (size_t i = 0; i < nearest.size(); ++i)
+				{
+					CHECK(near(nearest[i].Distance, expected[i]));
+					CHECK(nearest[i].Index < colors.size() && colors[nearest[i].Index] == nearest[i].Rgba);
+				}
+
+				//halfway between two neighbours, so rounding doesn't decide which side a color is on
+				const float radius = (expected[20] + expected[21]) * 0.5f;
+				const std::vector<LitColorIndex::Result> within = index.FindWithinRadius(LitColor(reference), radius);
+				const size_t count = static_cast<size_t>(std::upper_bound(expected.begin(), expected.end(), radius) - expected.begin());
+				CHECK(expected[21] - expected[20] < 0.001f || within.size() == count);
+
+				for (size_t i = 1; i < within.size(); ++i)
+					CHECK(within[i - 1].Distance <= within[i].Distance);
+			}
+		}
+	}
+}
+
+//exact colors are found at distance 0, an empty index finds nothing
+static void testExact()
+{
+	const std::vector<LitColor> colors = { LitColor(0xFF0000FFu), LitColor(0x00FF00FFu), LitColor(0x0000FFFFu), LitColor(0xFF000080u) };
+	LitColorIndex index(LitColorIndex::SPACE_RGBA);
+	index.Build(colors);
+	const std::vector<LitColorIndex::Result> nearest = index.FindNearest(LitColor(0xFF000080u), 2);
+	CHECK(nearest.size() == 2);
+	CHECK(nearest[0].Index == 3 && nearest[0].Distance == 0.0f);
+	CHECK(nearest[1].Index == 0 && near(nearest[1].Distance, 127.0f));
+	CHECK(index.FindNearest(LitColor(0xFF0000FFu), 0).empty());
+	CHECK(index.FindNearest(LitColor(0xFF0000FFu), 10).size() == colors.size());
+
+	LitColorIndex empty;
+	empty.Build(std::vector<uint32_t>());
+	CHECK(empty.FindNearest(LitColor(0xFF0000FFu), 3).empty());
+	CHECK(empty.FindWithinRadius(LitColor(0xFF0000FFu), 100.0f).empty());
+}
+
+int main()
+{
+	testAgainstBruteForce();
+	testExact();
+	return 0;
+}
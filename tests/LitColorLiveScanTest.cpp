@@ -0,0 +1,147 @@
+﻿#include <algorithm>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorLiveScan.h"
+#include "LitColor/LitColorWriter.h"
+
+#ifdef __linux__
+#include <linux/userfaultfd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+#ifndef UFFD_FEATURE_WP_ASYNC
+#define UFFD_FEATURE_WP_UNPOPULATED (1 << 13)
+#define UFFD_FEATURE_WP_ASYNC (1 << 15)
+#endif
+
+#ifndef UFFD_USER_MODE_ONLY
+#define UFFD_USER_MODE_ONLY 1
+#endif
+static bool contains(const std::vector<LitColorHit>& hits, const uint64_t address)
+{
+	return std::find_if(hits.begin(), hits.end(), [address](const LitColorHit& hit) { return hit.Address == address; }) != hits.end();
+}
+
+//a hit at the start of a clean page behind a written page must survive the partial rescan
+static void testPageBoundary()
+{
+	const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	uint8_t* pages = static_cast<uint8_t*>(mmap(nullptr, pageSize * 3, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+	CHECK(pages != MAP_FAILED);
+	const uint64_t base = reinterpret_cast<uintptr_t>(pages);
+
+	LitColorTestChild child([pages, pageSize]()
+	{
+		LitColorScanner::WriteValue<uint32_t>(pages + pageSize * 2, 0xFF8020FFu, true);
+	});
+
+	if (!child.CanAccess())
+		std::exit(TEST_SKIPPED);
+
+	LitColorLiveScan live(child.GetPid(), LitColorScanner(LitColor(0xFF8020FFu), LitColor::RGBA8888, true));
+	CHECK(contains(live.Update(), base + pageSize * 2));
+
+	LitColorWriter writer(child.GetPid());
+	writer.Add(base + pageSize + 8, LitColor(0xFF8020FFu), LitColor::RGBA8888, true);
+	CHECK(writer.Write() == 4);
+
+	const std::vector<LitColorHit>& hits = live.Update({ { base + pageSize, base + pageSize * 2, true, "" } });
+	CHECK(contains(hits, base + pageSize + 8));
+	CHECK(contains(hits, base + pageSize * 2));
+	CHECK(live.GetLastScannedBytes() < pageSize * 3);
+
+	//a value straddling into the written page is found again, the clean page is still kept
+	writer.Clear();
+	writer.Add(base + pageSize - 2, LitColor(0xFF8020FFu), LitColor::RGBA8888, true);
+	CHECK(writer.Write() == 4);
+	LitColorLiveScan unaligned(child.GetPid(), LitColorScanner(LitColor(0xFF8020FFu), LitColor::RGBA8888, true, 1));
+	unaligned.Update();
+	const std::vector<LitColorHit>& straddling = unaligned.Update({ { base + pageSize, base + pageSize * 2, true, "" } });
+	CHECK(contains(straddling, base + pageSize - 2));
+	CHECK(contains(straddling, base + pageSize * 2));
+
+	CHECK(child.Finish());
+	munmap(pages, pageSize * 3);
+}
+
+//asks the kernel to track writes to memory like a process opting into exact live scans would. The descriptor stays open
+static bool trackWrites(void* memory, const size_t size)
+{
+	const int fd = static_cast<int>(syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY));
+
+	if (fd < 0)
+		return false;
+
+	uffdio_api api = {};
+	api.api = UFFD_API;
+	api.features = UFFD_FEATURE_WP_ASYNC | UFFD_FEATURE_WP_UNPOPULATED;
+	uffdio_register registration = {};
+	registration.range = { reinterpret_cast<uintptr_t>(memory), size };
+	registration.mode = UFFDIO_REGISTER_MODE_WP;
+	uffdio_writeprotect protection = {};
+	protection.range = registration.range;
+	protection.mode = UFFDIO_WRITEPROTECT_MODE_WP;
+	return ioctl(fd, UFFDIO_API, &api) == 0 && ioctl(fd, UFFDIO_REGISTER, &registration) == 0 && ioctl(fd, UFFDIO_WRITEPROTECT, &protection) == 0;
+}
+
+//written pages of tracked memory are rescanned alone, even without soft-dirty bits
+static void testWriteTracking()
+{
+	const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	void* probe = mmap(nullptr, pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	CHECK(probe != MAP_FAILED);
+	const bool supported = trackWrites(probe, pageSize);
+	munmap(probe, pageSize);
+
+	if (!supported)
+		return;
+
+	uint8_t* pages = static_cast<uint8_t*>(mmap(nullptr, pageSize * 3, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+	CHECK(pages != MAP_FAILED);
+	const uint64_t base = reinterpret_cast<uintptr_t>(pages);
+
+	LitColorTestChild child([pages, pageSize]()
+	{
+		LitColorScanner::WriteValue<uint32_t>(pages + pageSize * 2, 0xFF8020FFu, true);
+
+		if (!trackWrites(pages, pageSize * 3))
+			_exit(1);
+	});
+
+	if (!child.CanAccess())
+		std::exit(TEST_SKIPPED);
+
+	LitColorLiveScan live(child.GetPid(), LitColorScanner(LitColor(0xFF8020FFu), LitColor::RGBA8888, true));
+	CHECK(contains(live.Update(), base + pageSize * 2));
+
+	LitColorWriter writer(child.GetPid());
+	writer.Add(base + pageSize + 8, LitColor(0xFF8020FFu), LitColor::RGBA8888, true);
+	CHECK(writer.Write() == 4);
+
+	const std::vector<LitColorHit>& hits = live.Update();
+	CHECK(contains(hits, base + pageSize + 8));
+	CHECK(contains(hits, base + pageSize * 2));
+
+	//other regions are read whole without soft-dirty bits, of the tracked pages only the written one is read
+	uint64_t mapped = 0;
+
+	for (const auto& region : LitColorProcess::GetRegions(child.GetPid(), true))
+		mapped += region.GetSize();
+
+	CHECK(live.GetLastScannedBytes() < mapped - pageSize);
+	CHECK(live.Update().size() == hits.size());
+	CHECK(child.Finish());
+	munmap(pages, pageSize * 3);
+}
+#endif
+
+int main()
+{
+#ifdef __linux__
+	testPageBoundary();
+	testWriteTracking();
+	return 0;
+#else
+	return TEST_SKIPPED;
+#endif
+}
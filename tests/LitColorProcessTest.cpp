@@ -0,0 +1,60 @@
+﻿#include <algorithm>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorProcess.h"
+
+#ifdef __linux__
+//scans and reads the memory of a child process that changed its colors after the fork
+static void testScanChild()
+{
+	std::vector<uint32_t> pixels(0x40000, 0x11223344);
+	uint32_t* data = pixels.data();
+
+	LitColorTestChild child([data]()
+	{
+		data[0x1234] = LitColorScanner::SwapBytes(0xFF8020FFu);
+		data[0x30000] = LitColorScanner::SwapBytes(0xFF8020FFu);
+	});
+
+	if (!child.CanAccess())
+		std::exit(TEST_SKIPPED);
+
+	LitColorProcess process(child.GetPid());
+	process.SetBatchSize(0x10000);
+	const LitColorScanner scanner(LitColor(0xFF8020FFu), LitColor::RGBA8888, true);
+	const LitColorMemoryRegion region = { reinterpret_cast<uintptr_t>(data), reinterpret_cast<uintptr_t>(data + pixels.size()), true, "" };
+	std::vector<LitColorHit> hits = process.Scan(scanner, { region });
+	std::sort(hits.begin(), hits.end());
+
+	CHECK(hits.size() == 2);
+	CHECK(hits[0].Address == reinterpret_cast<uintptr_t>(data + 0x1234));
+	CHECK(hits[1].Address == reinterpret_cast<uintptr_t>(data + 0x30000));
+	CHECK(hits[0].Type == LitColor::RGBA8888);
+
+	uint8_t value[4];
+	CHECK(process.Read(hits[1].Address, value, sizeof(value)) == sizeof(value));
+	CHECK(LitColorScanner::DecodeAt(value, LitColor::RGBA8888, true).GetRGBA() == 0xFF8020FFu);
+
+	//the parent's copy is untouched
+	CHECK(pixels[0x1234] == 0x11223344);
+
+	//regions from /proc/pid/maps include the vector's heap memory
+	bool found = false;
+
+	for (const auto& mapped : process.GetRegions(true))
+		found |= mapped.Begin <= region.Begin && region.End <= mapped.End;
+
+	CHECK(found);
+	CHECK(child.Finish());
+}
+#endif
+
+int main()
+{
+#ifdef __linux__
+	testScanChild();
+	return 0;
+#else
+	return TEST_SKIPPED;
+#endif
+}
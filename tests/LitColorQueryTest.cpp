@@ -0,0 +1,203 @@
+﻿#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <random>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorScanner.h"
+
+static const int TYPES[] = { LitColor::RGB888, LitColor::RGBA8888, LitColor::RGBF, LitColor::RGBAF, LitColor::RGB565, LitColor::RGB5A3, LitColor::RGBA16F };
+
+static uint32_t withChannel(const uint32_t rgba, const int channel, const int val)
+{
+	const int shift = 24 - channel * 8;
+	return (rgba & ~(0xFFu << shift)) | static_cast<uint32_t>(val) << shift;
+}
+
+//every 16 bit code matches exactly when it is the target's own code
+static void testRgb565Codes()
+{
+	const LitColor target(0xFF8020FFu);
+	const LitColorQuery query(target, LitColor::RGB565);
+	std::vector<uint8_t> codes(0x20000);
+
+	for (uint32_t code = 0; code < 0x10000; ++code)
+	{
+		LitColorScanner::WriteValue<uint16_t>(codes.data() + code * 2, static_cast<uint16_t>(code), true);
+		CHECK(query.Matches(codes.data() + code * 2) == (code == target.GetRGB565()));
+	}
+
+	std::vector<size_t> offsets;
+	query.ForEachMatch(codes.data(), 0, codes.size() - 1, 2, [&](const size_t offset) { offsets.push_back(offset); });
+	CHECK(offsets.size() == 1 && offsets[0] == static_cast<size_t>(target.GetRGB565()) * 2);
+}
+
+static void testTolerance()
+{
+	const uint32_t target = 0x80402010u;
+	const LitColorQuery tolerance = LitColorQuery::Tolerance(LitColor(target), LitColor::RGBA8888, 8, false);
+	const LitColorQuery range = LitColorQuery::Range(LitColor(0x70301000u), LitColor(0x90503020u), LitColor::RGBA8888, false);
+	uint8_t bytes[4];
+
+	for (int channel = LitColor::RED; channel <= LitColor::ALPHA; ++channel)
+	{
+		const int val = static_cast<int>((target >> (24 - channel * 8)) & 0xFF);
+
+		for (int delta = std::max(-20, -val); delta <= 20; ++delta)
+		{
+			LitColorScanner::WriteValue<uint32_t>(bytes, withChannel(target, channel, val + delta), false);
+			CHECK(tolerance.Matches(bytes) == (std::abs(delta) <= 8));
+			CHECK(range.Matches(bytes) == (std::abs(delta) <= 16));
+		}
+	}
+}
+
+static void testMasked()
+{
+	const LitColorQuery query = LitColorQuery::Masked(LitColor(0xFF8020FFu), LitColor::RGBA8888, LitColorQuery::CHANNEL_RED | LitColorQuery::CHANNEL_GREEN);
+	uint8_t bytes[4];
+	LitColorScanner::WriteValue<uint32_t>(bytes, 0xFF801234u, true);
+	CHECK(query.Matches(bytes));
+	LitColorScanner::WriteValue<uint32_t>(bytes, 0xFF812034u, true);
+	CHECK(!query.Matches(bytes));
+
+	//alpha only counts if the target uses it
+	CHECK(LitColorQuery(LitColor(0xFF802000u, false), LitColor::RGBA8888).Matches(bytes) == false);
+	LitColorScanner::WriteValue<uint32_t>(bytes, 0xFF802077u, true);
+	CHECK(LitColorQuery(LitColor(0xFF802000u, false), LitColor::RGBA8888).Matches(bytes));
+	CHECK(!LitColorQuery(LitColor(0xFF802000u), LitColor::RGBA8888).Matches(bytes));
+}
+
+//float channels outside 0.0 - 1.0 never match, not even in the widest range
+static void testInvalidFloats()
+{
+	const LitColor target(1.0f, 0.5f, 0.25f, 1.0f);
+	const LitColorQuery exact(target, LitColor::RGBAF);
+	const LitColorQuery any = LitColorQuery::Range(LitColor(0x00000000u), LitColor(0xFFFFFFFFu), LitColor::RGBAF);
+	const LitColorQuery anyHalf = LitColorQuery::Range(LitColor(0x00000000u), LitColor(0xFFFFFFFFu), LitColor::RGBA16F);
+	uint8_t bytes[16];
+	CHECK(LitColorScanner::EncodeAt(bytes, target, LitColor::RGBAF, true));
+	CHECK(exact.Matches(bytes) && any.Matches(bytes));
+
+	for (const float invalid : { 1.5f, -0.25f, NAN, INFINITY })
+	{
+		LitColorScanner::WriteValue<float>(bytes + 4, invalid, true);
+		CHECK(!exact.Matches(bytes) && !any.Matches(bytes));
+	}
+
+	for (const uint16_t invalid : std::initializer_list<uint16_t>{ 0x3C01, 0x7C00, 0x7E00, 0x8001, 0xBC00 })
+	{
+		const uint16_t halves[4] = { 0x3C00, invalid, 0x0000, 0x3800 };
+
+		for (int i = 0; i < 4; ++i)
+			LitColorScanner::WriteValue<uint16_t>(bytes + i * 2, halves[i], true);
+
+		CHECK(!anyHalf.Matches(bytes));
+	}
+
+	LitColorScanner::WriteValue<uint16_t>(bytes + 2, 0x3C00, true);
+	CHECK(anyHalf.Matches(bytes));
+}
+
+//the templated, dispatching and scanning paths agree on random data
+static void testPathsAgree()
+{
+	std::mt19937 random(42);
+	std::vector<uint8_t> data(0x4000);
+
+	for (auto& byte : data)
+		byte = static_cast<uint8_t>(random() % 4 ? random() : 0xFF);
+
+	size_t matched = 0;
+
+	for (const int type : TYPES)
+	{
+		const size_t typeSize = LitColorScanner::GetTypeSize(type);
+		const LitColorQuery queries[] = {
+			LitColorQuery(LitColor(0xFFFFFFFFu), type),
+			LitColorQuery::Tolerance(LitColor(0xF0F0F0F0u), type, 40, false),
+			LitColorQuery::Masked(LitColor(0xFF00FFFFu), type, LitColorQuery::CHANNEL_RED)
+		};
+
+		for (const auto& query : queries)
+		{
+			std::vector<size_t> expected;
+
+			for (size_t offset = 0; offset + typeSize <= data.size(); ++offset)
+				if (query.Matches(data.data() + offset))
+					expected.push_back(offset);
+
+			std::vector<size_t> found;
+			query.ForEachMatch(data.data(), 0, data.size() - typeSize + 1, 1, [&](const size_t offset) { found.push_back(offset); });
+			CHECK(found == expected);
+			matched += found.size();
+		}
+	}
+
+	CHECK(matched > 0);
+}
+
+//one pass finds what a scan per format finds, plus rounded 16 bit codes
+static void testCrossFormat()
+{
+	const LitColor target(0xF08020FFu);
+	std::mt19937 random(7);
+	std::vector<uint8_t> data(0x1000);
+
+	for (auto& byte : data)
+		byte = static_cast<uint8_t>(random());
+
+	size_t offset = 0x10;
+
+	for (const int type : TYPES)
+	{
+		CHECK(LitColorScanner::EncodeAt(data.data() + offset, target, type, true));
+		offset += 0x20;
+	}
+
+	//0xF08020 rounded to 5/6/5 bits, LitColor truncates red to 30
+	const uint16_t rounded = static_cast<uint16_t>(29 << 11 | 32 << 5 | 4);
+	CHECK(rounded != target.GetRGB565());
+	LitColorScanner::WriteValue<uint16_t>(data.data() + offset, rounded, true);
+
+	const std::vector<LitColorHit> hits = LitColorScanner(LitColorCrossFormatQuery(target), 1).Scan(data.data(), data.size());
+
+	for (const int type : TYPES)
+	{
+		std::vector<uint64_t> expected;
+
+		for (const auto& hit : LitColorScanner(target, type, true, 1).Scan(data.data(), data.size()))
+			expected.push_back(hit.Address);
+
+		std::vector<uint64_t> found;
+
+		for (const auto& hit : hits)
+			if (hit.Type == type)
+				found.push_back(hit.Address);
+
+		CHECK(!expected.empty());
+
+		if (type == LitColor::RGB565)
+		{
+			CHECK(std::includes(found.begin(), found.end(), expected.begin(), expected.end()));
+			CHECK(std::find(found.begin(), found.end(), offset) != found.end());
+		}
+		else if (type != LitColor::RGB5A3)
+			CHECK(found == expected);
+	}
+
+	//only the requested formats are reported
+	for (const auto& hit : LitColorScanner(LitColorCrossFormatQuery(target, LitColorCrossFormatQuery::FORMAT_RGBAF), 1).Scan(data.data(), data.size()))
+		CHECK(hit.Type == LitColor::RGBAF);
+}
+
+int main()
+{
+	testRgb565Codes();
+	testTolerance();
+	testMasked();
+	testInvalidFloats();
+	testPathsAgree();
+	testCrossFormat();
+	return 0;
+}
@@ -0,0 +1,146 @@
+﻿#include <cstring>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorScanSession.h"
+
+#ifdef __linux__
+#include "LitColor/LitColorWriter.h"
+#endif
+
+static const LitColor GREEN(0x00FF00FFu);
+static const LitColor RED(0xFF0000FFu);
+
+//a green pixel every 0x100 bytes, some misaligned ones in between
+static std::vector<uint8_t> makeDump()
+{
+	std::vector<uint8_t> dump(0x10000, 0);
+
+	for (size_t offset = 0; offset + 4 <= dump.size(); offset += 0x100)
+		LitColorScanner::WriteValue<uint32_t>(dump.data() + offset, GREEN.GetRGBA(), true);
+
+	LitColorScanner::WriteValue<uint32_t>(dump.data() + 0x1082, GREEN.GetRGBA(), true);
+	return dump;
+}
+
+static bool sameHits(const LitColorHitSpan& span, const std::vector<LitColorHit>& hits)
+{
+	if (span.GetSize() != hits.size())
+		return false;
+
+	for (size_t i = 0; i < hits.size(); ++i)
+		if (span[i].Address != hits[i].Address || span[i].Type != hits[i].Type)
+			return false;
+
+	return true;
+}
+
+//threaded scans are sorted without sorting, refinements shrink into the same allocation and rewinding undoes them
+static void testDump()
+{
+	std::vector<uint8_t> dump = makeDump();
+	const LitColorScanner scanner(GREEN, LitColor::RGBA8888, true, 2);
+	LitColorScanSession session(0x10000, 0x10000, 3);
+
+	const LitColorHitSpan hits = session.Scan(scanner, dump.data(), dump.size(), 0x1000);
+	CHECK(hits.GetSize() == 0x101);
+	CHECK(sameHits(hits, scanner.Scan(dump.data(), dump.size(), 0x1000)));
+	const LitColorArena::Marker marker = session.GetMarker();
+	const size_t used = session.GetUsedBytes();
+
+	//every other pixel turns red
+	for (size_t offset = 0; offset + 4 <= dump.size(); offset += 0x200)
+		LitColorScanner::WriteValue<uint32_t>(dump.data() + offset, RED.GetRGBA(), true);
+
+	const LitColorHitSpan green = session.Refine(hits, GREEN, dump.data(), dump.size(), 0x1000);
+	CHECK(green.GetSize() == 0x81);
+	CHECK(sameHits(green, scanner.Scan(dump.data(), dump.size(), 0x1000)));
+	CHECK(session.GetUsedBytes() == used + green.GetSize() * sizeof(LitColorHit));
+
+	const LitColorQuery red(RED, LitColor::RGBA8888);
+	const LitColorHitSpan redHits = session.Refine(hits, red, dump.data(), dump.size(), 0x1000);
+	CHECK(redHits.GetSize() == 0x80);
+	CHECK(redHits[0].Address == 0x1000 && redHits[1].Address == 0x1200);
+
+	//hits outside the dump never match
+	CHECK(session.Refine(hits, GREEN, dump.data(), dump.size(), 0x2000).GetSize() < green.GetSize());
+
+	session.Rewind(marker);
+	CHECK(session.GetUsedBytes() == used);
+	const size_t reserved = session.GetReservedBytes();
+	session.Reset();
+	CHECK(session.GetUsedBytes() == 0);
+	CHECK(sameHits(session.Scan(scanner, dump.data(), dump.size(), 0x1000), scanner.Scan(dump.data(), dump.size(), 0x1000)));
+	CHECK(session.GetReservedBytes() == reserved);
+}
+
+static void testArena()
+{
+	LitColorArena arena(0x1000);
+	uint8_t* first = arena.Allocate<uint8_t>(3);
+	uint64_t* second = arena.Allocate<uint64_t>(4);
+	CHECK(reinterpret_cast<uintptr_t>(second) % alignof(uint64_t) == 0);
+	CHECK(reinterpret_cast<uint8_t*>(second) >= first + 3);
+
+	//only the latest allocation can shrink
+	const size_t used = arena.GetUsedBytes();
+	arena.Shrink(first, 1);
+	CHECK(arena.GetUsedBytes() == used);
+	arena.Shrink(second, sizeof(uint64_t));
+	CHECK(arena.GetUsedBytes() == used - 3 * sizeof(uint64_t));
+	CHECK(arena.Allocate<uint64_t>(1) == second + 1);
+
+	//larger than a block, gets a block of its own
+	const size_t reserved = arena.GetReservedBytes();
+	uint8_t* large = arena.Allocate<uint8_t>(reserved + 1);
+	std::memset(large, 0xAB, reserved + 1);
+	CHECK(arena.GetReservedBytes() > reserved);
+
+	arena.Reset();
+	CHECK(arena.GetUsedBytes() == 0);
+	CHECK(arena.Allocate<uint8_t>(3) == first);
+	arena.Release();
+	CHECK(arena.GetReservedBytes() == 0);
+}
+
+#ifdef __linux__
+//hits in a child are refined after the child's colors changed
+static void testProcess()
+{
+	std::vector<uint8_t> dump = makeDump();
+	uint8_t* data = dump.data();
+	LitColorTestChild child([]() {});
+
+	if (!child.CanAccess())
+		std::exit(TEST_SKIPPED);
+
+	const LitColorScanner scanner(GREEN, LitColor::RGBA8888, true, 2);
+	const uint64_t base = reinterpret_cast<uintptr_t>(data);
+	const LitColorMemoryRegion region = { base, base + dump.size(), true, "" };
+	LitColorProcess process(child.GetPid());
+	LitColorScanSession session(0x10000, 0x10000, 2);
+
+	const LitColorHitSpan hits = session.Scan(process, scanner, { region });
+	CHECK(hits.GetSize() == 0x101);
+
+	LitColorWriter writer(child.GetPid());
+	CHECK(writer.Add(base + 0x100, RED, LitColor::RGBA8888));
+	CHECK(writer.Add(base + 0x1082, RED, LitColor::RGBA8888));
+	CHECK(writer.Write() == 8);
+
+	const LitColorHitSpan green = session.Refine(hits, GREEN, child.GetPid());
+	CHECK(green.GetSize() == 0xFF);
+	const LitColorHitSpan red = session.Refine(hits, LitColorQuery(RED, LitColor::RGBA8888), child.GetPid());
+	CHECK(red.GetSize() == 2 && red[0].Address == base + 0x100 && red[1].Address == base + 0x1082);
+	CHECK(child.Finish());
+}
+#endif
+
+int main()
+{
+	testDump();
+	testArena();
+#ifdef __linux__
+	testProcess();
+#endif
+	return 0;
+}
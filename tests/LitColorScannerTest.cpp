@@ -0,0 +1,78 @@
+﻿#include <filesystem>
+#include <memory>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorScanner.h"
+
+static std::vector<uint8_t> makeDump(const size_t size)
+{
+	std::vector<uint8_t> dump(size, 0);
+
+	for (size_t offset = 0x40; offset + 4 <= size; offset += 0x1234 * 4)
+		LitColorScanner::WriteValue<uint32_t>(dump.data() + offset, 0xFF8020FFu, true);
+
+	return dump;
+}
+
+#ifdef __linux__
+static size_t getThreadCount()
+{
+	size_t count = 0;
+
+	for (const auto& entry : std::filesystem::directory_iterator("/proc/self/task"))
+		count += entry.is_directory();
+
+	return count;
+}
+#endif
+
+//same hits as the synchronous scan, on pool threads that outlive every call
+static void testScanAsync()
+{
+	const std::vector<uint8_t> dump = makeDump(0x400000);
+	LitColorScanner scanner(LitColor(0xFF8020FFu), LitColor::RGBA8888);
+	scanner.SetChunkSize(0x10000);
+	const std::vector<LitColorHit> expected = scanner.Scan(dump.data(), dump.size(), 0x1000);
+	CHECK(!expected.empty());
+
+	auto progress = std::make_shared<LitColorScanProgress>();
+	CHECK(scanner.ScanAsync(dump.data(), dump.size(), 0x1000, progress).get().size() == expected.size());
+	CHECK(progress->IsFinished() && progress->GetBytesProcessed() == dump.size());
+
+#ifdef __linux__
+	const size_t threads = getThreadCount();
+#endif
+
+	for (int i = 0; i < 20; ++i)
+	{
+		const std::vector<LitColorHit> hits = scanner.ScanAsync(dump.data(), dump.size(), 0x1000, nullptr, nullptr, 1 + i % 4).get();
+		CHECK(hits.size() == expected.size());
+
+		for (size_t j = 0; j < hits.size(); ++j)
+			CHECK(hits[j].Address == expected[j].Address);
+	}
+
+#ifdef __linux__
+	CHECK(getThreadCount() == threads);
+#endif
+}
+
+//a cancelled progress object is reset by the next scan
+static void testCancel()
+{
+	const std::vector<uint8_t> dump = makeDump(0x100000);
+	LitColorScanner scanner(LitColor(0xFF8020FFu), LitColor::RGBA8888);
+	auto progress = std::make_shared<LitColorScanProgress>();
+	progress->Reset(0);
+	progress->Cancel();
+	CHECK(scanner.ScanAsync(dump.data(), dump.size(), 0, progress).get().size() == scanner.Scan(dump.data(), dump.size()).size());
+	CHECK(!progress->IsCancelled());
+	CHECK(progress->GetPercentage() == 100.0f);
+}
+
+int main()
+{
+	testScanAsync();
+	testCancel();
+	return 0;
+}
@@ -0,0 +1,144 @@
+﻿#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorSessionFile.h"
+
+//offsets into the on disk header and block index
+constexpr size_t TARGETS_OFFSET = 40;
+constexpr size_t BLOCKS_OFFSET = 48;
+constexpr size_t BLOCK_SIZE = 40;
+constexpr size_t BLOCK_LAST_ADDRESS = 8;
+constexpr size_t BLOCK_OFFSET = 16;
+constexpr size_t BLOCK_TYPE = 32;
+constexpr size_t BLOCK_SHIFT = 34;
+
+static std::string tempPath(const std::string& name)
+{
+	return (std::filesystem::temp_directory_path() / ("litcolor_" + name)).string();
+}
+
+static std::vector<uint8_t> readFile(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const std::string& path, const std::vector<uint8_t>& data)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+static uint64_t get64(const std::vector<uint8_t>& data, const size_t offset)
+{
+	uint64_t val;
+	std::memcpy(&val, data.data() + offset, sizeof(val));
+	return val;
+}
+
+//a modified copy of a valid file must not open
+template<typename T> static void checkRejected(const std::string& path, const std::vector<uint8_t>& valid, const size_t offset, const T val)
+{
+	std::vector<uint8_t> corrupt = valid;
+	std::memcpy(corrupt.data() + offset, &val, sizeof(val));
+	writeFile(path, corrupt);
+	LitColorSessionFile file;
+	CHECK(!file.Open(path));
+	CHECK(!file.IsOpen());
+}
+
+static void testCorruptIndex()
+{
+	const std::string path = tempPath("session.lcs");
+	std::vector<LitColorHit> hits;
+
+	//three blocks
+	for (uint64_t i = 0; i < LitColorSessionFile::HITS_PER_BLOCK * 2 + 10; ++i)
+		hits.push_back({ 0x1000 + i * 4, LitColor::RGBA8888 });
+
+	CHECK(LitColorSessionFile::Save(path, { LitColorSessionTarget() }, hits));
+	const std::vector<uint8_t> valid = readFile(path);
+
+	{
+		LitColorSessionFile file(path);
+		CHECK(file.IsOpen());
+		CHECK(file.GetBlockCount() == 3);
+		CHECK(file.GetHits().size() == hits.size());
+	}
+
+	const size_t blocks = static_cast<size_t>(get64(valid, BLOCKS_OFFSET));
+
+	//offsets that wrap around when the size is added
+	checkRejected(path, valid, TARGETS_OFFSET, ~0ull - 7);
+	checkRejected(path, valid, BLOCKS_OFFSET, ~0ull - 7);
+	checkRejected(path, valid, blocks + BLOCK_SIZE + BLOCK_OFFSET, ~0ull - 15);
+
+	//unsorted index
+	checkRejected(path, valid, blocks + BLOCK_LAST_ADDRESS, get64(valid, blocks + BLOCK_SIZE) + 4);
+	checkRejected(path, valid, blocks + BLOCK_SIZE + BLOCK_LAST_ADDRESS, get64(valid, blocks + BLOCK_SIZE) - 4);
+
+	//shifts past the width of an address and unknown types
+	checkRejected<uint8_t>(path, valid, blocks + BLOCK_SHIFT, 64);
+	checkRejected<uint8_t>(path, valid, blocks + BLOCK_SIZE * 2 + BLOCK_SHIFT, 0xFF);
+	checkRejected<int16_t>(path, valid, blocks + BLOCK_TYPE, LitColor::RGBA16F + 1);
+	checkRejected<int16_t>(path, valid, blocks + BLOCK_SIZE + BLOCK_TYPE, -1);
+	checkRejected<int16_t>(path, valid, blocks + BLOCK_TYPE, 0x7FFF);
+	std::filesystem::remove(path);
+}
+
+//per hit types of a mixed block are checked when it is decoded
+static void testCorruptTypes()
+{
+	const std::string path = tempPath("session.lcs");
+	const int spaceType = LitColorSpaceQuery(LitColor(0xFF8020FFu), LitColorSpaceQuery::SPACE_HSV).GetType();
+	const std::vector<LitColorHit> hits = { { 0x1000, LitColor::RGBA8888 }, { 0x1004, LitColor::RGB565 }, { 0x1008, spaceType } };
+	CHECK(LitColorSessionFile::Save(path, {}, hits));
+	std::vector<uint8_t> data = readFile(path);
+
+	{
+		LitColorSessionFile file(path);
+		const std::vector<LitColorHit> restored = file.GetHits();
+		CHECK(restored.size() == 3 && restored[1].Type == LitColor::RGB565 && restored[2].Type == spaceType);
+	}
+
+	//two delta bytes, then one type code per hit
+	const size_t codes = data.size() - 3;
+	CHECK(data[codes] == LitColor::RGBA8888 && data[codes + 1] == LitColor::RGB565);
+	data[codes + 1] = 0x7F;
+	writeFile(path, data);
+	LitColorSessionFile unknown(path);
+	CHECK(unknown.IsOpen() && unknown.GetHits().empty());
+	unknown.Close();
+
+	data[codes + 1] = 0xFF;
+	writeFile(path, data);
+	LitColorSessionFile unknownSpace(path);
+	CHECK(unknownSpace.IsOpen() && unknownSpace.GetHits().empty());
+	unknownSpace.Close();
+	std::filesystem::remove(path);
+}
+
+//only exact scans fit into a target, anything else would reload as a different scan
+static void testMakeTarget()
+{
+	LitColorSessionTarget target;
+	CHECK(LitColorSessionFile::MakeTarget(LitColorScanner(LitColor(0xFF8020FFu), LitColor::RGB565, false, 2), target));
+	CHECK(target.Type == LitColor::RGB565 && target.Alignment == 2 && target.BigEndian == 0);
+
+	CHECK(!LitColorSessionFile::MakeTarget(LitColorScanner(LitColorQuery::Tolerance(LitColor(0xFF8020FFu), LitColor::RGBA8888, 8)), target));
+	CHECK(!LitColorSessionFile::MakeTarget(LitColorScanner(LitColorQuery(LitColor(0xFF8020FFu), LitColor::RGBA8888)), target));
+	CHECK(!LitColorSessionFile::MakeTarget(LitColorScanner(LitColorCrossFormatQuery(LitColor(0xFF8020FFu))), target));
+	CHECK(!LitColorSessionFile::MakeTarget(LitColorScanner(LitColorSpaceQuery(LitColor(0xFF8020FFu), LitColorSpaceQuery::SPACE_HSV)), target));
+}
+
+int main()
+{
+	testCorruptIndex();
+	testCorruptTypes();
+	testMakeTarget();
+	return 0;
+}
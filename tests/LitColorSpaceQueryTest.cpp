@@ -0,0 +1,63 @@
+﻿#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorScanner.h"
+
+//one HSV byte triple per hue byte, saturation and value of the target
+static std::vector<uint8_t> makeTriples(const uint8_t saturation, const uint8_t value)
+{
+	std::vector<uint8_t> triples;
+
+	for (int hue = 0; hue < 256; ++hue)
+	{
+		triples.push_back(static_cast<uint8_t>(hue));
+		triples.push_back(saturation);
+		triples.push_back(value);
+	}
+
+	return triples;
+}
+
+//with an 8 bit hue of 0 - 179, bytes 180 - 255 must not wrap around to match red
+static void testHueRange()
+{
+	const LitColorSpaceQuery query(LitColor(0xFF0000FFu), LitColorSpaceQuery::SPACE_HSV, LitColorSpaceQuery::LAYOUT_BYTES, true, 180.0f);
+	const std::vector<uint8_t> triples = makeTriples(0xFF, 0xFF);
+	const std::vector<LitColorHit> hits = LitColorScanner(query, 3).Scan(triples.data(), triples.size());
+
+	CHECK(hits.size() == 3);
+	CHECK(hits[0].Address == 0 && hits[1].Address == 3 && hits[2].Address == 179 * 3);
+
+	for (int hue = 180; hue < 256; ++hue)
+		CHECK(!query.Matches(triples.data() + hue * 3));
+}
+
+//a gray ignores the hue, but only valid hues
+static void testIgnoredHue()
+{
+	const LitColorSpaceQuery query(LitColor(0x808080FFu), LitColorSpaceQuery::SPACE_HSV, LitColorSpaceQuery::LAYOUT_BYTES, true, 180.0f);
+	const std::vector<uint8_t> triples = makeTriples(0, 0x80);
+	const std::vector<LitColorHit> hits = LitColorScanner(query, 3).Scan(triples.data(), triples.size());
+
+	CHECK(hits.size() == 180);
+	CHECK(hits.back().Address == 179 * 3);
+	CHECK(!query.Matches(triples.data() + 200 * 3));
+}
+
+//by default 255 bytes make a full turn, so 254 is next to red and 255 is out of range
+static void testDefaultRange()
+{
+	const LitColorSpaceQuery query(LitColor(0xFF0000FFu), LitColorSpaceQuery::SPACE_HSV);
+	const std::vector<uint8_t> triples = makeTriples(0xFF, 0xFF);
+	const std::vector<LitColorHit> hits = LitColorScanner(query, 3).Scan(triples.data(), triples.size());
+
+	CHECK(hits.size() == 3);
+	CHECK(hits[0].Address == 0 && hits[1].Address == 3 && hits[2].Address == 254 * 3);
+}
+
+int main()
+{
+	testHueRange();
+	testIgnoredHue();
+	testDefaultRange();
+	return 0;
+}
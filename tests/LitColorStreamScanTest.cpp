@@ -0,0 +1,112 @@
+﻿#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorStreamScan.h"
+
+static const LitColorScanner SCANNER(LitColor(0xFF8020FFu), LitColor::RGBA8888, true);
+
+static std::string tempPath(const std::string& name)
+{
+	return (std::filesystem::temp_directory_path() / ("litcolor_" + name)).string();
+}
+
+static void writeFile(const std::string& path, const void* data, const size_t size)
+{
+	std::ofstream file(path, std::ios::binary);
+	file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+}
+
+//a dump with colors at the start, across the first block boundary and at the end
+static std::vector<uint8_t> makeDump()
+{
+	std::vector<uint8_t> dump(0x3000, 0);
+	const uint64_t offsets[] = { 0, 0xFFE, 0x2FFC };
+
+	for (const uint64_t offset : offsets)
+		LitColorScanner::WriteValue<uint32_t>(dump.data() + offset, 0xFF8020FFu, true);
+
+	return dump;
+}
+
+static void checkHits(const std::vector<LitColorHit>& hits)
+{
+	CHECK(hits.size() == 3);
+	CHECK(hits[0].Address == 0x1000);
+	CHECK(hits[1].Address == 0x1FFE);
+	CHECK(hits[2].Address == 0x3FFC);
+}
+
+static void testFile()
+{
+	const std::vector<uint8_t> dump = makeDump();
+	const std::string path = tempPath("stream.bin");
+	writeFile(path, dump.data(), dump.size());
+
+	const LitColorScanner unaligned(LitColor(0xFF8020FFu), LitColor::RGBA8888, true, 1);
+	LitColorFileSource source(path);
+	bool success = false;
+	checkHits(LitColorStreamScan(unaligned, 0x1000).Scan(source, 0x1000, nullptr, &success));
+	CHECK(success);
+
+	LitColorFileSource missing(tempPath("missing.bin"));
+	CHECK(LitColorStreamScan(SCANNER).Scan(missing, 0, nullptr, &success).empty());
+	CHECK(!success);
+	std::filesystem::remove(path);
+}
+
+//compressed is checked whole, then cut in half
+template<typename Source> static void checkCompressed(const std::vector<uint8_t>& compressed, const std::string& name)
+{
+	const std::string path = tempPath(name);
+	const LitColorScanner unaligned(LitColor(0xFF8020FFu), LitColor::RGBA8888, true, 1);
+	bool success = false;
+
+	writeFile(path, compressed.data(), compressed.size());
+	Source complete(path);
+	checkHits(LitColorStreamScan(unaligned, 0x1000).Scan(complete, 0x1000, nullptr, &success));
+	CHECK(success);
+
+	writeFile(path, compressed.data(), compressed.size() / 2);
+	Source truncated(path);
+	LitColorStreamScan(unaligned, 0x1000).Scan(truncated, 0x1000, nullptr, &success);
+	CHECK(!success);
+	std::filesystem::remove(path);
+}
+
+#ifdef LITCOLOR_WITH_ZSTD
+static void testZstd()
+{
+	const std::vector<uint8_t> dump = makeDump();
+	std::vector<uint8_t> compressed(ZSTD_compressBound(dump.size()));
+	const size_t size = ZSTD_compress(compressed.data(), compressed.size(), dump.data(), dump.size(), 1);
+	CHECK(!ZSTD_isError(size));
+	compressed.resize(size);
+	checkCompressed<LitColorZstdSource>(compressed, "stream.bin.zst");
+}
+#endif
+
+#ifdef LITCOLOR_WITH_LZ4
+static void testLz4()
+{
+	const std::vector<uint8_t> dump = makeDump();
+	std::vector<uint8_t> compressed(LZ4F_compressFrameBound(dump.size(), nullptr));
+	const size_t size = LZ4F_compressFrame(compressed.data(), compressed.size(), dump.data(), dump.size(), nullptr);
+	CHECK(!LZ4F_isError(size));
+	compressed.resize(size);
+	checkCompressed<LitColorLz4Source>(compressed, "stream.bin.lz4");
+}
+#endif
+
+int main()
+{
+	testFile();
+#ifdef LITCOLOR_WITH_ZSTD
+	testZstd();
+#endif
+#ifdef LITCOLOR_WITH_LZ4
+	testLz4();
+#endif
+	return 0;
+}
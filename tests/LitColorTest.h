@@ -0,0 +1,91 @@
+﻿#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#define CHECK(condition) do { if (!(condition)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); std::exit(1); } } while (false)
+
+constexpr int TEST_SKIPPED = 77;
+
+#ifdef __linux__
+//a forked copy of the test process that stays alive until Finish(). Memory set up before the fork is at the same addresses in the child
+class LitColorTestChild
+{
+private:
+	pid_t _pid = 0;
+	int _ready[2] = { -1, -1 };
+	int _finish[2] = { -1, -1 };
+
+public:
+	//setup runs in the child before the parent continues, verify runs in the child on Finish()
+	LitColorTestChild(const std::function<void()>& setup, const std::function<bool()>& verify = nullptr)
+	{
+		CHECK(pipe(_ready) == 0 && pipe(_finish) == 0);
+		_pid = fork();
+		CHECK(_pid >= 0);
+
+		if (_pid == 0)
+		{
+			//the child must not hold the write end itself, so a parent that exits on a failed check unblocks it
+			close(_ready[0]);
+			close(_finish[1]);
+			setup();
+			char signal = 1;
+			CHECK(write(_ready[1], &signal, 1) == 1);
+			const bool finished = read(_finish[0], &signal, 1) == 1;
+			_exit(finished && (!verify || verify()) ? 0 : 1);
+		}
+
+		close(_ready[1]);
+		close(_finish[0]);
+		char signal;
+		CHECK(read(_ready[0], &signal, 1) == 1);
+	}
+
+	~LitColorTestChild()
+	{
+		Finish();
+	}
+
+	pid_t GetPid() const
+	{
+		return _pid;
+	}
+
+	//true if the child's verify callback passed
+	bool Finish()
+	{
+		if (_pid <= 0)
+			return false;
+
+		char signal = 1;
+		int status = 0;
+		CHECK(write(_finish[1], &signal, 1) == 1);
+		waitpid(_pid, &status, 0);
+		_pid = 0;
+
+		close(_ready[0]);
+		close(_finish[1]);
+
+		return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	}
+
+	//false if this system doesn't allow reading another process' memory, e.g. because of ptrace restrictions
+	bool CanAccess() const
+	{
+		char val;
+		iovec local = { &val, 1 };
+		iovec remote = { &val, 1 };
+		return process_vm_readv(_pid, &local, 1, &remote, 1, 0) == 1 || (errno != EPERM && errno != ENOSYS);
+	}
+};
+#endif
@@ -0,0 +1,98 @@
+﻿#include <chrono>
+#include <thread>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorTracker.h"
+#include "LitColor/LitColorWriter.h"
+
+//fully saturated color at hue degrees
+static uint32_t hueColor(const int hue)
+{
+	const int sector = hue / 60 % 6;
+	const uint32_t rising = static_cast<uint32_t>(hue % 60 * 255 / 60);
+	const uint32_t falling = 255 - rising;
+	const uint32_t rgb[6][3] = { { 255, rising, 0 }, { falling, 255, 0 }, { 0, 255, rising }, { 0, falling, 255 }, { rising, 0, 255 }, { 255, 0, falling } };
+	return rgb[sector][0] << 24 | rgb[sector][1] << 16 | rgb[sector][2] << 8 | 0xFF;
+}
+
+//dumps in a series, one color constant and one cycling through the hues
+static void testDumps()
+{
+	std::vector<uint8_t> dump(16, 0);
+	LitColorTracker tracker({ { 0x1008, LitColor::RGBA8888 }, { 0x1000, LitColor::RGBA8888 }, { 0x2000, LitColor::RGBA8888 } });
+
+	for (int i = 0; i < 12; ++i)
+	{
+		LitColorScanner::WriteValue<uint32_t>(dump.data(), 0x00FF00FFu, true);
+		LitColorScanner::WriteValue<uint32_t>(dump.data() + 8, hueColor(i * 20), true);
+		tracker.Sample(dump.data(), dump.size(), 0x1000);
+	}
+
+	const std::vector<LitColorTracker::Result> results = tracker.GetResults();
+	CHECK(results.size() == 3);
+	CHECK(results[0].Address == 0x1000 && results[0].Behavior == LitColorTracker::BEHAVIOR_CONSTANT);
+	CHECK(results[1].Address == 0x1008 && results[1].Behavior == LitColorTracker::BEHAVIOR_HUE_CYCLE);
+	CHECK(results[1].HueRate > 15.0f && results[1].HueRate < 25.0f);
+	CHECK(results[2].InvalidCount == 12 && results[2].Behavior == LitColorTracker::BEHAVIOR_UNKNOWN);
+	CHECK(tracker.GetHistory(1).back() == hueColor(220));
+}
+
+#ifdef __linux__
+//colors changed in a child between samples show up in the tracker
+static void testProcess()
+{
+	std::vector<uint32_t> pixels(0x400, 0);
+	uint32_t* data = pixels.data();
+	LitColorTestChild child([data]()
+	{
+		data[0] = LitColorScanner::SwapBytes(0x00FF00FFu);
+	});
+
+	if (!child.CanAccess())
+		std::exit(TEST_SKIPPED);
+
+	const uint64_t constant = reinterpret_cast<uintptr_t>(data);
+	const uint64_t cycling = reinterpret_cast<uintptr_t>(data + 0x200);
+	LitColorTracker tracker({ { constant, LitColor::RGBA8888 }, { cycling, LitColor::RGBA8888 } });
+	LitColorWriter writer(child.GetPid());
+
+	for (int i = 0; i < 12; ++i)
+	{
+		writer.Clear();
+		CHECK(writer.Add(cycling, LitColor(hueColor(i * 20)), LitColor::RGBA8888));
+		CHECK(writer.Write() == 4);
+		CHECK(tracker.Sample(child.GetPid()));
+	}
+
+	const std::vector<LitColorTracker::Result> results = tracker.GetResults();
+	CHECK(results[0].Behavior == LitColorTracker::BEHAVIOR_CONSTANT && results[0].Latest == 0x00FF00FFu);
+	CHECK(results[1].Behavior == LitColorTracker::BEHAVIOR_HUE_CYCLE && results[1].Latest == hueColor(220));
+	CHECK(results[1].InvalidCount == 0);
+
+	//the background thread keeps sampling until it is stopped
+	tracker.Reset();
+	tracker.StartSampling(child.GetPid(), 1000.0);
+	CHECK(tracker.IsSampling());
+
+	for (int i = 0; i < 1000 && tracker.GetSampleCount() < 4; ++i)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	tracker.StopSampling();
+	CHECK(!tracker.IsSampling());
+	const uint64_t samples = tracker.GetSampleCount();
+	CHECK(samples >= 4);
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	CHECK(tracker.GetSampleCount() == samples);
+	CHECK(tracker.GetResult(1).Latest == hueColor(220));
+	CHECK(child.Finish());
+}
+#endif
+
+int main()
+{
+	testDumps();
+#ifdef __linux__
+	testProcess();
+#endif
+	return 0;
+}
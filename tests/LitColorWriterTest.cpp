@@ -0,0 +1,111 @@
+﻿#include <cstring>
+#include <thread>
+#include <vector>
+#include "tests/LitColorTest.h"
+#include "LitColor/LitColorProcess.h"
+#include "LitColor/LitColorWriter.h"
+
+#ifdef __linux__
+static std::vector<uint8_t> readBack(const LitColorProcess& process, const void* address, const size_t size)
+{
+	std::vector<uint8_t> bytes(size);
+	CHECK(process.Read(reinterpret_cast<uintptr_t>(address), bytes.data(), size) == size);
+	return bytes;
+}
+
+//writes the hits of a scan back into a child and reads them again
+static void testRoundTrip()
+{
+	std::vector<uint32_t> pixels(0x1000, 0);
+	uint32_t* data = pixels.data();
+	const uint32_t oldColor = LitColorScanner::SwapBytes(0x00FF00FFu);
+	const uint32_t newColor = LitColorScanner::SwapBytes(0xFF0000FFu);
+
+	LitColorTestChild child([data, oldColor]()
+	{
+		data[3] = oldColor;
+		data[0x800] = oldColor;
+	},
+	[data, newColor]()
+	{
+		//the child sees the written values in its own memory
+		return data[3] == newColor && data[0x800] == newColor && data[4] == 0;
+	});
+
+	if (!child.CanAccess())
+		std::exit(TEST_SKIPPED);
+
+	LitColorProcess process(child.GetPid());
+	const LitColorMemoryRegion region = { reinterpret_cast<uintptr_t>(data), reinterpret_cast<uintptr_t>(data + pixels.size()), true, "" };
+	const std::vector<LitColorHit> hits = process.Scan(LitColorScanner(LitColor(0x00FF00FFu), LitColor::RGBA8888, true), { region });
+	CHECK(hits.size() == 2);
+
+	LitColorWriter writer(child.GetPid());
+	writer.Add(hits, LitColor(0xFF0000FFu), true);
+	CHECK(writer.GetIovecCount() == 2);
+	CHECK(writer.Write() == 8);
+	CHECK(process.Scan(LitColorScanner(LitColor(0xFF0000FFu), LitColor::RGBA8888, true), { region }).size() == 2);
+	CHECK(process.Scan(LitColorScanner(LitColor(0x00FF00FFu), LitColor::RGBA8888, true), { region }).empty());
+	CHECK(child.Finish());
+}
+
+//the patch added last wins on every overlapping byte, whatever its address
+static void testOverlaps()
+{
+	std::vector<uint8_t> bytes(64, 0);
+	uint8_t* data = bytes.data();
+	LitColorTestChild child([]() {});
+
+	if (!child.CanAccess())
+		std::exit(TEST_SKIPPED);
+
+	LitColorProcess process(child.GetPid());
+	const uint64_t base = reinterpret_cast<uintptr_t>(data);
+	LitColorWriter writer(child.GetPid());
+	writer.Add(base + 2, LitColor(0x11111111u), LitColor::RGBA8888, true);
+	writer.Add(base, LitColor(0x22222222u), LitColor::RGBA8888, true);
+	writer.Add(base + 5, LitColor(0x33333333u), LitColor::RGBA8888, true);
+	writer.Add(base + 6, LitColor(0x44444444u), LitColor::RGB565, true);
+	CHECK(writer.GetIovecCount() == 1);
+	CHECK(writer.Write() == 9);
+
+	const std::vector<uint8_t> expected = { 0x22, 0x22, 0x22, 0x22, 0x11, 0x33, 0x42, 0x28, 0x33, 0x00 };
+	CHECK(readBack(process, data, expected.size()) == expected);
+
+	//the freeze thread writes the compiled patches until it is stopped
+	writer.Clear();
+	writer.Add(base + 32, LitColor(0x55555555u), LitColor::RGBA8888, true);
+	writer.StartFreeze(std::chrono::milliseconds(1));
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	writer.StopFreeze();
+	CHECK(!writer.IsFreezing());
+	CHECK(readBack(process, data + 32, 4) == std::vector<uint8_t>(4, 0x55));
+	CHECK(child.Finish());
+}
+
+//space types have no encoding, nothing is queued and scanner values stay untouched
+static void testSpaceTypes()
+{
+	const int type = LitColorSpaceQuery(LitColor(0xFF8020FFu), LitColorSpaceQuery::SPACE_HSV).GetType();
+	uint8_t bytes[3] = { 1, 2, 3 };
+	CHECK(!LitColorScanner::EncodeAt(bytes, LitColor(0xFF8020FFu), type, true));
+	CHECK(bytes[0] == 1 && bytes[1] == 2 && bytes[2] == 3);
+
+	LitColorWriter writer(getpid());
+	CHECK(!writer.Add(0x1000, LitColor(0xFF8020FFu), type));
+	writer.Add({ { 0x2000, type }, { 0x3000, LitColor::RGBA8888 } }, LitColor(0xFF8020FFu));
+	CHECK(writer.GetPatchCount() == 1);
+}
+#endif
+
+int main()
+{
+#ifdef __linux__
+	testSpaceTypes();
+	testRoundTrip();
+	testOverlaps();
+	return 0;
+#else
+	return TEST_SKIPPED;
+#endif
+}